@@ -0,0 +1,127 @@
+#include "denoisebench.h"
+
+#include <code/utility/clock_time.h>
+#include <code/video/denoise.h>
+
+#include <QTextStream>
+#include <opencv2/core/ocl.hpp>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/videoio.hpp>
+#include <algorithm>
+#include <cstdlib>
+
+DenoiseBench::Result::Result() :
+    contours(0),
+    contour_jitter(0),
+    edge_overlap(0) {}
+
+DenoiseBench::DenoiseBench(std::vector<cv::Mat> frames, int warmup) :
+    m_frames(std::move(frames)),
+    m_warmup(std::max(0, warmup)),
+    m_results(Denoiser::NUM_METHODS) {
+    // Keep the cost of every measured frame
+    std::size_t window = m_frames.size() > static_cast<std::size_t>(m_warmup) ? m_frames.size() - m_warmup : 1;
+    for (Result &result : m_results) { result.cost = latency_window(window); }
+}
+
+std::vector<cv::Mat> DenoiseBench::read_frames(cv::VideoCapture &source, int count) {
+    std::vector<cv::Mat> frames;
+    cv::Mat frame;
+    while (static_cast<int>(frames.size()) < count && source.read(frame) && !frame.empty()) {
+        cv::Mat gray;
+        cv::cvtColor(frame, gray, cv::COLOR_BGR2GRAY);
+        frames.push_back(gray);
+    }
+    return frames;
+}
+
+void DenoiseBench::run() {
+    cv::UMat gray;
+    cv::UMat denoised;
+    cv::UMat edges;
+    cv::UMat last_edges;
+    cv::UMat both;
+    std::vector<std::vector<cv::Point>> contours;
+    for (int method = 0; method < Denoiser::NUM_METHODS; ++method) {
+        Result &result = m_results[method];
+        Denoiser denoiser(method);
+        last_edges.release();
+        std::size_t last_count = 0;
+        std::size_t measured = 0;
+        std::size_t compared = 0;
+        for (std::size_t i = 0; i < m_frames.size(); ++i) {
+            m_frames[i].copyTo(gray);
+            std::int64_t start = ClockTime::monotonic_ns();
+            denoiser.apply(gray, denoised);
+            // Wait for offloaded work so that it is counted
+            cv::ocl::finish();
+            std::int64_t end = ClockTime::monotonic_ns();
+
+            // Edges and contours as found by the shape detector
+            cv::Canny(denoised, edges, 0, 50, 5);
+            cv::findContours(edges.clone(), contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
+            if (static_cast<int>(i) >= m_warmup) {
+                result.cost.add(end - start);
+                result.contours += contours.size();
+                ++measured;
+                if (!last_edges.empty()) {
+                    cv::bitwise_and(edges, last_edges, both);
+                    int overlap = cv::countNonZero(both);
+                    cv::bitwise_or(edges, last_edges, both);
+                    int total = cv::countNonZero(both);
+                    result.edge_overlap += total > 0 ? static_cast<double>(overlap) / total : 1.0;
+                    result.contour_jitter += std::abs(static_cast<long>(contours.size()) - static_cast<long>(last_count));
+                    ++compared;
+                }
+            }
+            edges.copyTo(last_edges);
+            last_count = contours.size();
+        }
+        if (measured > 0) { result.contours /= measured; }
+        if (compared > 0) {
+            result.contour_jitter /= compared;
+            result.edge_overlap /= compared;
+        }
+    }
+}
+
+std::size_t DenoiseBench::measured() const {
+    return m_results.empty() ? 0 : m_results.front().cost.count();
+}
+
+void DenoiseBench::print_table(QTextStream &out) const {
+    constexpr double ns_per_ms = 1e6;
+    out << QString("%1 frames\n").arg(measured());
+    out << QString("%1 %2 %3 %4 %5 %6\n")
+        .arg("method", -16).arg("p50 ms", 10).arg("p99 ms", 10)
+        .arg("contours", 10).arg("jitter", 10).arg("edge IoU", 10);
+    for (int method = 0; method < Denoiser::NUM_METHODS; ++method) {
+        const Result &result = m_results[method];
+        out << QString("%1 %2 %3 %4 %5 %6\n")
+            .arg(Denoiser::name(method), -16)
+            .arg(result.cost.percentile(50) / ns_per_ms, 10, 'f', 2)
+            .arg(result.cost.percentile(99) / ns_per_ms, 10, 'f', 2)
+            .arg(result.contours, 10, 'f', 1)
+            .arg(result.contour_jitter, 10, 'f', 2)
+            .arg(result.edge_overlap, 10, 'f', 3);
+    }
+    out.flush();
+}
+
+QJsonObject DenoiseBench::to_json() const {
+    QJsonObject methods;
+    for (int method = 0; method < Denoiser::NUM_METHODS; ++method) {
+        const Result &result = m_results[method];
+        QJsonObject entry;
+        entry["p50_ns"] = static_cast<double>(result.cost.percentile(50));
+        entry["p99_ns"] = static_cast<double>(result.cost.percentile(99));
+        entry["contours"] = result.contours;
+        entry["contour_jitter"] = result.contour_jitter;
+        entry["edge_overlap"] = result.edge_overlap;
+        methods[Denoiser::name(method)] = entry;
+    }
+    QJsonObject results;
+    results["frames"] = static_cast<int>(measured());
+    results["methods"] = methods;
+    return results;
+}
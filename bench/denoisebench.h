@@ -0,0 +1,90 @@
+#ifndef MINOTAUR_CPP_DENOISEBENCH_H
+#define MINOTAUR_CPP_DENOISEBENCH_H
+
+#include <QJsonObject>
+#include <opencv2/core/core.hpp>
+#include <vector>
+
+#include <code/utility/latency.h>
+
+class QTextStream;
+
+namespace cv {
+    class VideoCapture;
+}
+
+/**
+ * Compares the denoise methods of the shape detector on the same frames.
+ * Each method filters the grayscale frames in order, as the detector
+ * would, and is measured by its cost per frame and by how stable the
+ * edges and contours found downstream are from one frame to the next.
+ * Noise that survives the filter shows up as flickering edges and a
+ * jittering contour count.
+ */
+class DenoiseBench {
+public:
+    enum {
+        DEFAULT_FRAMES = 300,
+        DEFAULT_WARMUP = 30
+    };
+
+    /**
+     * Measurements of one method.
+     */
+    struct Result {
+        Result();
+
+        // Nanoseconds taken to denoise each frame
+        latency_window cost;
+        // Mean number of contours per frame
+        double contours;
+        // Mean absolute change in the contour count between frames
+        double contour_jitter;
+        // Mean intersection over union of the edges of consecutive frames
+        double edge_overlap;
+    };
+
+    /**
+     * @param frames grayscale frames to denoise
+     * @param warmup number of leading frames that are not measured
+     */
+    DenoiseBench(std::vector<cv::Mat> frames, int warmup);
+
+    /**
+     * Read frames from a source and convert them to grayscale.
+     *
+     * @param source camera or recording
+     * @param count  number of frames to read
+     * @return the frames read, fewer at the end of a recording
+     */
+    static std::vector<cv::Mat> read_frames(cv::VideoCapture &source, int count);
+
+    /**
+     * Run every method over the frames.
+     */
+    void run();
+
+    /**
+     * Write the results as a table.
+     *
+     * @param out stream to write to
+     */
+    void print_table(QTextStream &out) const;
+
+    /**
+     * @return the results as a JSON object
+     */
+    QJsonObject to_json() const;
+
+    /**
+     * @return number of frames measured for each method
+     */
+    std::size_t measured() const;
+
+private:
+    std::vector<cv::Mat> m_frames;
+    int m_warmup;
+    std::vector<Result> m_results;
+};
+
+#endif //MINOTAUR_CPP_DENOISEBENCH_H
@@ -0,0 +1,127 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonDocument>
+#include <QTextStream>
+
+#include <code/camera/frame.h>
+#include <code/camera/replaycamera.h>
+#include <code/simulator/fakecamera.h>
+#include <code/utility/utility.h>
+#include <code/video/modify.h>
+
+#include "denoisebench.h"
+#include "pipelinebench.h"
+
+/**
+ * Write the results as JSON to a file, or to the stream for "-".
+ *
+ * @param results   results to write
+ * @param file_name file to write
+ * @param out       standard output
+ * @return whether the results were written
+ */
+static bool write_json(const QJsonObject &results, const QString &file_name, QTextStream &out) {
+    QByteArray json = QJsonDocument(results).toJson();
+    if (file_name == "-") {
+        out << json;
+        return true;
+    }
+    QFile file(file_name);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(json) != json.size()) {
+        QTextStream(stderr) << "Could not write " << file_name << "\n";
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Compare the shape detector denoise methods on frames of the source.
+ *
+ * @param options   source and frame counts
+ * @param json_file file to write JSON results to, if not empty
+ * @return the exit code
+ */
+static int run_denoise_bench(const PipelineBench::Options &options, const QString &json_file) {
+    std::unique_ptr<cv::VideoCapture> source;
+    if (!options.replay_file.isEmpty()) {
+        source = std::make_unique<ReplayCamera>(options.replay_file.toStdString(), ReplayCamera::AS_FAST_AS_POSSIBLE);
+    } else if (options.camera == FakeCamera::FAKE_CAMERA) {
+        source = std::make_unique<FakeCamera>();
+        source->open(FakeCamera::FAKE_CAMERA);
+    } else {
+        source = std::make_unique<cv::VideoCapture>(options.camera);
+    }
+    DenoiseBench bench(DenoiseBench::read_frames(*source, options.warmup + options.frames), options.warmup);
+    bench.run();
+
+    QTextStream out(stdout);
+    if (bench.measured() == 0) {
+        QTextStream(stderr) << "No frames were measured\n";
+        return 1;
+    }
+    bench.print_table(out);
+    if (!json_file.isEmpty() && !write_json(bench.to_json(), json_file, out)) { return 1; }
+    return 0;
+}
+
+/**
+ * Headless benchmark of the camera pipeline. Runs the FakeCamera, a live
+ * camera, or a replayed recording through the preprocessor with a chosen
+ * modifier and the converter, and reports throughput, per-stage latency
+ * percentiles, frame buffer allocations per frame, and skipped and
+ * dropped frames. With --denoise, compares the shape detector denoise
+ * methods on frames of the source instead.
+ *
+ * Example: minotaur-bench --modifier 2 --replay run.session --json out.json
+ */
+int main(int argc, char *argv[]) {
+    qRegisterMetaType<std::shared_ptr<VideoModifier>>();
+    qRegisterMetaType<Frame>();
+    qRegisterMetaType<FrameMeta>();
+
+    QCoreApplication app(argc, argv);
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Measure the camera pipeline without the user interface");
+    parser.addHelpOption();
+    QCommandLineOption frames_option("frames", "Number of frames to measure.", "n",
+                                     QString::number(PipelineBench::DEFAULT_FRAMES));
+    QCommandLineOption warmup_option("warmup", "Number of frames to skip before measuring.", "n",
+                                     QString::number(PipelineBench::DEFAULT_WARMUP));
+    QCommandLineOption modifier_option("modifier", "Video modifier index, as listed in the camera display.", "index",
+                                       "0");
+    QCommandLineOption camera_option("camera", "Camera index; the simulated camera by default.", "index");
+    QCommandLineOption replay_option("replay", "Session or video file to replay.", "file");
+    QCommandLineOption real_time_option("real-time", "Replay at the recorded frame rate.");
+    QCommandLineOption json_option("json", "Also write the results as JSON to a file, or - for stdout.", "file");
+    QCommandLineOption denoise_option("denoise", "Compare the shape detector denoise methods instead.");
+    parser.addOptions({
+        frames_option, warmup_option, modifier_option,
+        camera_option, replay_option, real_time_option, json_option, denoise_option
+    });
+    parser.process(app);
+
+    PipelineBench::Options options;
+    options.frames = parser.value(frames_option).toInt();
+    options.warmup = parser.value(warmup_option).toInt();
+    // The modifier list starts with "None"
+    options.modifier = parser.value(modifier_option).toInt() - 1;
+    if (parser.isSet(camera_option)) { options.camera = parser.value(camera_option).toInt(); }
+    options.replay_file = parser.value(replay_option);
+    options.pacing = parser.isSet(real_time_option) ? ReplayCamera::REAL_TIME : ReplayCamera::AS_FAST_AS_POSSIBLE;
+    if (parser.isSet(denoise_option)) { return run_denoise_bench(options, parser.value(json_option)); }
+
+    PipelineBench bench(options);
+    QObject::connect(&bench, &PipelineBench::finished, &app, &QCoreApplication::quit, Qt::QueuedConnection);
+    bench.start();
+    app.exec();
+
+    QTextStream out(stdout);
+    if (bench.measured() == 0) {
+        QTextStream(stderr) << "No frames were measured\n";
+        return 1;
+    }
+    bench.print_table(out);
+    if (parser.isSet(json_option) && !write_json(bench.to_json(), parser.value(json_option), out)) { return 1; }
+    return 0;
+}
@@ -0,0 +1,203 @@
+#include "pipelinebench.h"
+
+#include <code/camera/camerathread.h>
+#include <code/camera/capture.h>
+#include <code/camera/converter.h>
+#include <code/camera/frame.h>
+#include <code/camera/preprocessor.h>
+#include <code/camera/replaycamera.h>
+#include <code/simulator/fakecamera.h>
+#include <code/utility/clock_time.h>
+#include <code/utility/utility.h>
+#include <code/video/modify.h>
+
+#include <QImage>
+#include <QTextStream>
+#include <QTimerEvent>
+#include <algorithm>
+
+enum {
+    // Time in milliseconds between checks of the idle timeout
+    IDLE_CHECK_INTERVAL = 100
+};
+
+static const char *const INTERVAL_NAMES[PipelineBench::NUM_INTERVALS] = {
+    "capture", "queue", "preprocess", "modify", "convert", "total"
+};
+
+static std::int64_t interval(const FrameMeta &meta, PipelineBench::Interval interval) {
+    switch (interval) {
+        case PipelineBench::CAPTURE:
+            return meta.exit_time[FrameMeta::CAPTURE] - meta.enter_time[FrameMeta::CAPTURE];
+        case PipelineBench::QUEUE:
+            return meta.enter_time[FrameMeta::PREPROCESS] - meta.exit_time[FrameMeta::CAPTURE];
+        case PipelineBench::PREPROCESS:
+            return meta.exit_time[FrameMeta::PREPROCESS] - meta.enter_time[FrameMeta::PREPROCESS];
+        case PipelineBench::MODIFY:
+            // Not reached without a modifier
+            if (!meta.passed(FrameMeta::MODIFY)) { return -1; }
+            return meta.exit_time[FrameMeta::MODIFY] - meta.enter_time[FrameMeta::MODIFY];
+        case PipelineBench::CONVERT:
+            return meta.exit_time[FrameMeta::CONVERT] - meta.enter_time[FrameMeta::CONVERT];
+        case PipelineBench::TOTAL:
+            return meta.latency(FrameMeta::CONVERT);
+        default:
+            return -1;
+    }
+}
+
+PipelineBench::Options::Options() :
+    camera(FakeCamera::FAKE_CAMERA),
+    pacing(ReplayCamera::AS_FAST_AS_POSSIBLE),
+    modifier(-1),
+    frames(DEFAULT_FRAMES),
+    warmup(DEFAULT_WARMUP),
+    idle_timeout(DEFAULT_IDLE_TIMEOUT) {}
+
+PipelineBench::PipelineBench(const Options &options) :
+    m_options(options),
+    m_capture(std::make_unique<Capture>()),
+    m_preprocessor(std::make_unique<Preprocessor>()),
+    m_converter(std::make_unique<Converter>(nullptr)),
+    // Every measured frame is kept for the percentiles
+    m_latency(NUM_INTERVALS, latency_window(static_cast<std::size_t>(std::max(options.frames, 1)))),
+    m_received(0),
+    m_start_allocations(0),
+    m_end_allocations(0),
+    m_start_dropped(0),
+    m_end_dropped(0),
+    m_start_skipped(0),
+    m_end_skipped(0),
+    m_start_time(0),
+    m_end_time(0),
+    m_last_frame_time(0),
+    m_idle_timer(0),
+    m_finished(false) {
+    m_preprocessor->use_modifier(VideoModifier::get_modifier(options.modifier));
+
+    // Connect the pipeline as the ImageViewer does
+    connect(m_capture.get(), &Capture::frame_ready, m_preprocessor.get(), &Preprocessor::preprocess_frame,
+            Qt::DirectConnection);
+    connect(m_preprocessor.get(), &Preprocessor::service_measured, m_capture.get(), &Capture::downstream_measured,
+            Qt::DirectConnection);
+    connect(m_capture.get(), &Capture::lossless_changed, m_preprocessor.get(), &Preprocessor::set_lossless,
+            Qt::DirectConnection);
+    connect(m_preprocessor.get(), &Preprocessor::frame_processed, m_converter.get(), &Converter::process_frame);
+    connect(m_converter.get(), &Converter::image_ready, this, &PipelineBench::frame_converted);
+}
+
+PipelineBench::~PipelineBench() {
+    // The capture must be stopped while the other stages still run
+    if (!m_finished && !m_threads.empty()) { finish(); }
+}
+
+void PipelineBench::start() {
+    QObject *stages[] = {m_capture.get(), m_preprocessor.get(), m_converter.get()};
+    for (QObject *stage : stages) {
+        m_threads.push_back(std::make_unique<IThread>());
+        m_threads.back()->start();
+        stage->moveToThread(m_threads.back().get());
+    }
+    m_last_frame_time = ClockTime::monotonic_ns();
+    m_idle_timer = startTimer(IDLE_CHECK_INTERVAL);
+    if (m_options.replay_file.isEmpty()) {
+        QMetaObject::invokeMethod(m_capture.get(), "start_capture", Qt::QueuedConnection,
+                                  Q_ARG(int, m_options.camera));
+    } else {
+        QMetaObject::invokeMethod(m_capture.get(), "change_replay", Qt::QueuedConnection,
+                                  Q_ARG(QString, m_options.replay_file), Q_ARG(int, m_options.pacing));
+    }
+}
+
+void PipelineBench::frame_converted(const QImage &, const FrameMeta &meta) {
+    if (m_finished) { return; }
+    std::int64_t now = ClockTime::monotonic_ns();
+    m_last_frame_time = now;
+    if (m_received++ < static_cast<std::size_t>(m_options.warmup)) { return; }
+    if (measured() == 0) {
+        // Measure from the first frame after the warm up
+        m_start_allocations = allocations();
+        m_start_dropped = m_preprocessor->queue_stats().dropped;
+        m_start_skipped = m_capture->skipped();
+        m_start_time = now;
+    }
+    for (int i = 0; i < NUM_INTERVALS; ++i) {
+        std::int64_t sample = interval(meta, static_cast<Interval>(i));
+        if (sample >= 0) { m_latency[i].add(sample); }
+    }
+    m_end_time = now;
+    if (measured() >= static_cast<std::size_t>(m_options.frames)) { finish(); }
+}
+
+void PipelineBench::timerEvent(QTimerEvent *ev) {
+    if (ev->timerId() != m_idle_timer) { return; }
+    std::int64_t idle = ClockTime::monotonic_ns() - m_last_frame_time;
+    if (idle > static_cast<std::int64_t>(m_options.idle_timeout) * 1000000) { finish(); }
+}
+
+void PipelineBench::finish() {
+    if (m_finished) { return; }
+    m_finished = true;
+    killTimer(m_idle_timer);
+    QMetaObject::invokeMethod(m_capture.get(), "stop_capture", Qt::BlockingQueuedConnection);
+    m_end_allocations = allocations();
+    m_end_dropped = m_preprocessor->queue_stats().dropped;
+    m_end_skipped = m_capture->skipped();
+    Q_EMIT finished();
+}
+
+std::size_t PipelineBench::allocations() const {
+    return m_capture->allocations() + m_preprocessor->allocations() + m_converter->allocations();
+}
+
+std::size_t PipelineBench::measured() const {
+    return m_latency[TOTAL].count();
+}
+
+void PipelineBench::print_table(QTextStream &out) const {
+    constexpr double ns_per_ms = 1e6;
+    QJsonObject results = to_json();
+    out << QString("%1 frames, %2 fps, %3 allocations/frame, %4 skipped, %5 dropped\n")
+        .arg(measured())
+        .arg(results["fps"].toDouble(), 0, 'f', 1)
+        .arg(results["allocations_per_frame"].toDouble(), 0, 'f', 3)
+        .arg(results["skipped"].toInt())
+        .arg(results["dropped"].toInt());
+    out << QString("%1 %2 %3\n").arg("stage", -12).arg("p50 ms", 10).arg("p99 ms", 10);
+    for (int i = 0; i < NUM_INTERVALS; ++i) {
+        const latency_window &window = m_latency[i];
+        if (!window.count()) { continue; }
+        out << QString("%1 %2 %3\n")
+            .arg(INTERVAL_NAMES[i], -12)
+            .arg(window.percentile(50) / ns_per_ms, 10, 'f', 2)
+            .arg(window.percentile(99) / ns_per_ms, 10, 'f', 2);
+    }
+    out.flush();
+}
+
+QJsonObject PipelineBench::to_json() const {
+    std::size_t frames = measured();
+    double elapsed = (m_end_time - m_start_time) * 1e-9;
+    std::size_t allocated = m_end_allocations - m_start_allocations;
+
+    QJsonObject stages;
+    for (int i = 0; i < NUM_INTERVALS; ++i) {
+        const latency_window &window = m_latency[i];
+        if (!window.count()) { continue; }
+        QJsonObject stage;
+        stage["p50_ns"] = static_cast<double>(window.percentile(50));
+        stage["p99_ns"] = static_cast<double>(window.percentile(99));
+        stages[INTERVAL_NAMES[i]] = stage;
+    }
+    QJsonObject results;
+    results["frames"] = static_cast<int>(frames);
+    results["modifier"] = m_options.modifier;
+    results["source"] = m_options.replay_file.isEmpty() ? QString::number(m_options.camera) : m_options.replay_file;
+    // The first measured frame starts the clock
+    results["fps"] = frames > 1 && elapsed > 0 ? (frames - 1) / elapsed : 0.0;
+    results["allocations_per_frame"] = frames > 0 ? static_cast<double>(allocated) / frames : 0.0;
+    results["skipped"] = static_cast<int>(m_end_skipped - m_start_skipped);
+    results["dropped"] = static_cast<int>(m_end_dropped - m_start_dropped);
+    results["stages"] = stages;
+    return results;
+}
@@ -0,0 +1,160 @@
+#ifndef MINOTAUR_CPP_PIPELINEBENCH_H
+#define MINOTAUR_CPP_PIPELINEBENCH_H
+
+#include <QJsonObject>
+#include <QObject>
+#include <QString>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <code/utility/latency.h>
+
+class Capture;
+class Converter;
+class IThread;
+class Preprocessor;
+class QImage;
+class QTextStream;
+struct FrameMeta;
+
+/**
+ * Runs the camera pipeline without any widgets and measures it. The
+ * Capture, Preprocessor and Converter run on their own threads, connected
+ * as in the ImageViewer, and converted frames are collected on the thread
+ * of the benchmark.
+ *
+ * After a number of warm up frames, which are not measured, per-stage
+ * latencies are recorded for each converted frame along with the frame
+ * buffers allocated, frames skipped by the capture to match the
+ * preprocessor's rate, and frames dropped by the preprocessor queue.
+ */
+class PipelineBench : public QObject {
+Q_OBJECT
+
+public:
+    /**
+     * Measured intervals of each frame.
+     */
+    enum Interval {
+        // Grab and retrieve from the device
+        CAPTURE,
+        // Waiting in the preprocessor queue
+        QUEUE,
+        // Modifier and transform stages
+        PREPROCESS,
+        // Modifier stage alone
+        MODIFY,
+        // Conversion to QImage
+        CONVERT,
+        // From capture to conversion
+        TOTAL,
+        NUM_INTERVALS
+    };
+
+    enum {
+        DEFAULT_FRAMES = 300,
+        DEFAULT_WARMUP = 30,
+        // Time in milliseconds without a frame after which the run ends,
+        // such as at the end of a replay
+        DEFAULT_IDLE_TIMEOUT = 5000
+    };
+
+    struct Options {
+        Options();
+
+        // Camera index, or the FakeCamera if no replay file is given
+        int camera;
+        // Session or video file to replay instead of the camera
+        QString replay_file;
+        // One of the ReplayCamera pacings
+        int pacing;
+        // One of the VideoModifier types, or -1 for none
+        int modifier;
+        // Number of measured frames
+        int frames;
+        // Number of frames to skip before measuring
+        int warmup;
+        int idle_timeout;
+    };
+
+    explicit PipelineBench(const Options &options);
+    ~PipelineBench() override;
+
+    /**
+     * Start the pipeline threads and the capture.
+     */
+    void start();
+
+    /**
+     * Signal emitted once the frames have been measured or the
+     * pipeline has gone idle. The capture has been stopped.
+     */
+    Q_SIGNAL void finished();
+
+    /**
+     * Write the results as a table.
+     *
+     * @param out stream to write to
+     */
+    void print_table(QTextStream &out) const;
+
+    /**
+     * @return the results as a JSON object
+     */
+    QJsonObject to_json() const;
+
+    /**
+     * @return number of frames measured
+     */
+    std::size_t measured() const;
+
+private:
+    /**
+     * Collect the metadata of a converted frame.
+     *
+     * @param meta metadata of the converted frame
+     */
+    Q_SLOT void frame_converted(const QImage &, const FrameMeta &meta);
+
+    void timerEvent(QTimerEvent *ev) override;
+
+    /**
+     * Stop the capture and emit finished().
+     */
+    void finish();
+
+    /**
+     * @return frame buffers allocated by all stages
+     */
+    std::size_t allocations() const;
+
+    Options m_options;
+
+    std::unique_ptr<Capture> m_capture;
+    std::unique_ptr<Preprocessor> m_preprocessor;
+    std::unique_ptr<Converter> m_converter;
+    // Declared after the stages so that threads stop before the
+    // stages are destroyed
+    std::vector<std::unique_ptr<IThread>> m_threads;
+
+    std::vector<latency_window> m_latency;
+    // Frames converted so far, including warm up frames
+    std::size_t m_received;
+    // Counters when measurement started and when it ended
+    std::size_t m_start_allocations;
+    std::size_t m_end_allocations;
+    std::size_t m_start_dropped;
+    std::size_t m_end_dropped;
+    std::size_t m_start_skipped;
+    std::size_t m_end_skipped;
+    // Monotonic times of the first and last measured frames
+    std::int64_t m_start_time;
+    std::int64_t m_end_time;
+    // Time of the last frame received, for the idle timeout
+    std::int64_t m_last_frame_time;
+    int m_idle_timer;
+    bool m_finished;
+};
+
+#endif //MINOTAUR_CPP_PIPELINEBENCH_H
@@ -0,0 +1,39 @@
+#include <opencv2/imgproc.hpp>
+
+#include "annotation.h"
+
+Annotation::Annotation(std::vector<cv::Point> outline, const cv::Scalar &color, int thickness, std::string label) :
+    outline(std::move(outline)),
+    color(color),
+    thickness(thickness),
+    label(std::move(label)) {}
+
+Annotation Annotation::rect(const cv::Rect2d &rect, const cv::Scalar &color, int thickness) {
+    cv::Point tl(cvRound(rect.x), cvRound(rect.y));
+    cv::Point br(cvRound(rect.x + rect.width), cvRound(rect.y + rect.height));
+    return Annotation({tl, {br.x, tl.y}, br, {tl.x, br.y}}, color, thickness);
+}
+
+// Displays text in the center of an outline on a white background
+static void draw_label(cv::InputOutputArray image, const std::string &label, const std::vector<cv::Point> &outline) {
+    constexpr int font_face = cv::FONT_HERSHEY_SIMPLEX;
+    constexpr double scale = 0.4;
+    constexpr int thickness = 1;
+    int baseline = 0;
+
+    cv::Size text = cv::getTextSize(label, font_face, scale, thickness, &baseline);
+    cv::Rect r = cv::boundingRect(outline);
+
+    cv::Point pt(r.x + ((r.width - text.width) / 2), r.y + ((r.height + text.height) / 2));
+    cv::rectangle(image, pt + cv::Point(0, baseline), pt + cv::Point(text.width, -text.height),
+                  cv::Scalar(255, 255, 255), cv::FILLED);
+    cv::putText(image, label, pt, font_face, scale, cv::Scalar(0, 0, 0), thickness, 8);
+}
+
+void draw_annotations(cv::InputOutputArray image, const annotation_list &annotations) {
+    for (const Annotation &annotation : annotations) {
+        if (annotation.outline.empty()) { continue; }
+        cv::polylines(image, annotation.outline, true, annotation.color, annotation.thickness);
+        if (!annotation.label.empty()) { draw_label(image, annotation.label, annotation.outline); }
+    }
+}
@@ -0,0 +1,47 @@
+#ifndef MINOTAUR_CPP_ANNOTATION_H
+#define MINOTAUR_CPP_ANNOTATION_H
+
+#include <opencv2/core/core.hpp>
+
+#include <string>
+#include <vector>
+
+/**
+ * A shape drawn over a frame, such as a tracker box or a detected shape.
+ * Modifiers add annotations to the frame instead of drawing on its pixels,
+ * and the ImageViewer draws them in its overlay.
+ */
+struct Annotation {
+    Annotation(std::vector<cv::Point> outline, const cv::Scalar &color, int thickness = 1,
+               std::string label = std::string());
+
+    /**
+     * @param rect      rectangle in frame pixels
+     * @param color     BGR outline colour
+     * @param thickness outline thickness
+     * @return an annotation outlining the rectangle
+     */
+    static Annotation rect(const cv::Rect2d &rect, const cv::Scalar &color, int thickness = 1);
+
+    // Closed outline in frame pixels
+    std::vector<cv::Point> outline;
+    // BGR colour, as for OpenCV drawing
+    cv::Scalar color;
+    // Outline thickness in frame pixels
+    int thickness;
+    // Text drawn over the centre of the outline, if not empty
+    std::string label;
+};
+
+typedef std::vector<Annotation> annotation_list;
+
+/**
+ * Draw annotations onto the pixels of an image, for outputs without an
+ * overlay such as recorded videos.
+ *
+ * @param image       BGR image to draw on
+ * @param annotations annotations to draw
+ */
+void draw_annotations(cv::InputOutputArray image, const annotation_list &annotations);
+
+#endif //MINOTAUR_CPP_ANNOTATION_H
@@ -10,7 +10,9 @@
 #include "actionbox.h"
 #include "actionbutton.h"
 #include "imageviewer.h"
+#include "replaycamera.h"
 
+#include "../compstate/parammanager.h"
 #include "../utility/logger.h"
 #include "../utility/utility.h"
 #include "../video/modify.h"
@@ -60,8 +62,9 @@ static void populate_camera_box(QComboBox *box) {
         // Push them to the combo box with their index
         box->addItem(cameras[i].deviceName(), QVariant::fromValue(i));
     }
-    // Add the simulated camera
+    // Add the simulated camera and the replay of a recording
     box->addItem("Simulated", QVariant::fromValue(i));
+    box->addItem("Replay File...", QVariant::fromValue(i + 1));
 }
 
 static void populate_effect_box(QComboBox *box) {
@@ -145,6 +148,7 @@ CameraDisplay::CameraDisplay(QWidget *parent) :
     connect(m_ui->weight_selector, qol<int>::of(&QSpinBox::valueChanged), this, &CameraDisplay::weighting_changed);
     connect(m_ui->picture_button, &QPushButton::clicked, this, &CameraDisplay::take_screen_shot);
     connect(m_ui->record_button, &QPushButton::clicked, this, &CameraDisplay::toggle_record);
+    connect(m_ui->dump_replay_button, &QPushButton::clicked, this, &CameraDisplay::dump_replay_pushed);
     connect(m_ui->show_grid_button, &QPushButton::clicked, this, &CameraDisplay::show_grid_button_pushed);
     connect(m_ui->hide_grid_button, &QPushButton::clicked, this, &CameraDisplay::hide_grid_button_pushed);
     connect(m_ui->clear_grid_button, &QPushButton::clicked, this, &CameraDisplay::clear_grid);
@@ -191,6 +195,13 @@ void CameraDisplay::camera_box_changed(int camera) {
         QCameraInfo info = cameras[camera];
         int camera_index = get_camera_index(info);
         Q_EMIT camera_changed(camera_index);
+    } else if (camera > cameras.size()) {
+        // Replay a recorded session or video
+        QString file = QFileDialog::getOpenFileName(
+            this, "Replay File", QDir::currentPath(), "Sessions (*.session);;Videos (*.avi *.mp4)");
+        if (file.isEmpty()) { return; }
+        log() << "Replaying: " << file;
+        Q_EMIT replay_changed(file, g_pm ? g_pm->replay_pacing : ReplayCamera::REAL_TIME);
     } else {
         // Emit fake camera if the index is out of range
         Q_EMIT camera_changed(FakeCamera::FAKE_CAMERA);
@@ -216,6 +227,18 @@ void CameraDisplay::take_screen_shot() {
     Q_EMIT save_screenshot(image_png);
 }
 
+void CameraDisplay::dump_replay_pushed() {
+    QString file = QFileDialog::getSaveFileName(
+        this, "Save Replay", QDir::currentPath(), "Sessions (*.session)");
+    if (file.isEmpty()) { return; }
+    request_replay_dump(file);
+}
+
+void CameraDisplay::request_replay_dump(const QString &file) {
+    log() << "Saving replay: " << file;
+    Q_EMIT dump_replay(file);
+}
+
 void CameraDisplay::update_zoom(int value) {
     // Scale the zoom factor
     double zoom_factor = value / 10.0;
@@ -4,6 +4,8 @@
 #include <QDialog>
 #include <memory>
 
+#include "../video/detection.h"
+
 // ui_cameradisplay
 namespace Ui {
     class CameraDisplay;
@@ -66,6 +68,20 @@ public:
      */
     Q_SLOT void take_screen_shot();
 
+    /**
+     * Slot called when the user clicks the dump replay button. Opens
+     * a FileDialog to get the session save path.
+     */
+    Q_SLOT void dump_replay_pushed();
+
+    /**
+     * Request that the instant replay buffer is written to a session
+     * file, without a dialog. Used by the Python API.
+     *
+     * @param file session save path
+     */
+    Q_SLOT void request_replay_dump(const QString &file);
+
     /**
      * Slot called when the zoom slider changes value. The value
      * from the slider must be scaled to the correct zoom level.
@@ -143,6 +159,14 @@ public:
      */
     Q_SIGNAL void camera_changed(int camera);
 
+    /**
+     * Signal fired when a recording is selected to replay.
+     *
+     * @param file   path of the session or video file
+     * @param pacing one of the ReplayCamera pacings
+     */
+    Q_SIGNAL void replay_changed(const QString &file, int pacing);
+
     /**
      * Signal fired with a shared pointer to the newly
      * selected video modifier. The preprocessor grabs and
@@ -159,6 +183,13 @@ public:
      */
     Q_SIGNAL void save_screenshot(const QString &file);
 
+    /**
+     * Signal fired to write the instant replay buffer to a session file.
+     *
+     * @param file session save path
+     */
+    Q_SIGNAL void dump_replay(const QString &file);
+
     /**
      * Signal fired with the scaled zoom value. The preprocessor grabs
      * this value and saves it to apply a zoom in the image pipeline.
@@ -224,6 +255,15 @@ public:
      */
     Q_SIGNAL void toggle_path(bool checked);
 
+    /**
+     * Signal forwarded from the preprocessor with the shapes detected in
+     * each processed frame, in frame order.
+     *
+     * @param detections   shapes detected in a frame
+     * @param capture_time monotonic time at which the frame was captured
+     */
+    Q_SIGNAL void detections_found(const detection_list &detections, qint64 capture_time);
+
     /**
      * Signal fired when the grid selection type changes.
      *
@@ -1,38 +1,96 @@
+#include <chrono>
 #include <QBasicTimer>
 #include <QTimerEvent>
 
 #include "capture.h"
+#include "frame.h"
+#include "framepool.h"
+#include "replaycamera.h"
+#include "../utility/clock_time.h"
 #include "../utility/utility.h"
 #include "../simulator/fakecamera.h"
 
 /**
  * Timer fires at a fixed interval to pull images
- * from the capture.
+ * from the FakeCamera.
  */
 static QBasicTimer s_capture_timer;
 
-Capture::Capture() = default;
+enum {
+    // Number of frame buffers reserved when capture starts
+    CAPTURE_RESERVE_BUFFERS = 4,
+    // Time in milliseconds to wait after a failed grab
+    CAPTURE_RETRY_INTERVAL = 5,
+    // Percentage of the downstream interval after which the next frame
+    // is retrieved, early enough that the preprocessor is not left idle
+    CAPTURE_ADAPT_HEADROOM = 80
+};
+
+Capture::Capture() :
+    m_pool(std::make_unique<FramePool>()),
+    m_frame_width(0),
+    m_frame_height(0),
+    m_sequence(0),
+    m_grabbing(false),
+    m_replay_pacing(ReplayCamera::REAL_TIME),
+    m_downstream_interval(0),
+    m_last_frame_time(0),
+    m_adaptive(true),
+    m_lossless(false),
+    m_skipped(0) {}
+
+Capture::~Capture() {
+    // The grab thread must not outlive the capture
+    join_grab_thread();
+}
 
 void Capture::start_capture(int cam) {
+    // The grab thread or timer of a running capture would otherwise be
+    // left reading a video capture that is replaced under it
+    if (m_grab_thread.joinable() || s_capture_timer.isActive()) { stop_capture(); }
     // Create the capture instance
     if (cam == FakeCamera::FAKE_CAMERA) {
         // Override capture instance with FakeCamera
         // if it has been selected
         m_video_capture = std::make_unique<FakeCamera>();
+    } else if (cam == ReplayCamera::REPLAY_CAMERA) {
+        m_video_capture = std::make_unique<ReplayCamera>(
+            m_replay_file.toStdString(),
+            static_cast<ReplayCamera::Pacing>(m_replay_pacing)
+        );
     } else {
         m_video_capture = std::make_unique<cv::VideoCapture>(cam);
     }
     if (m_video_capture->isOpened()) {
-        // Max at 30 frames per second
-        // Limit mainly applies to the FakeCamera so that
-        // Qt's event resources are clogged up
-        s_capture_timer.start(33, this);
+        // Reserve a few frame buffers at the capture size
+        m_frame_width = capture_width();
+        m_frame_height = capture_height();
+        m_pool->clear();
+        m_sequence = 0;
+        m_last_frame_time = 0;
+        if (m_frame_width > 0 && m_frame_height > 0) {
+            m_pool->reserve({m_frame_width, m_frame_height}, CV_8UC3, CAPTURE_RESERVE_BUFFERS);
+        }
+        // Every frame of a replay run as fast as possible is processed
+        m_lossless = cam == ReplayCamera::REPLAY_CAMERA && m_replay_pacing == ReplayCamera::AS_FAST_AS_POSSIBLE;
+        Q_EMIT lossless_changed(m_lossless);
+        if (cam == FakeCamera::FAKE_CAMERA) {
+            // Max at 30 frames per second so that
+            // Qt's event resources are not clogged up
+            s_capture_timer.start(33, this);
+        } else {
+            // Live cameras block on each grab at their own rate, as
+            // does a replay in real time
+            m_grabbing = true;
+            m_grab_thread = std::thread(&Capture::grab_loop, this);
+        }
         Q_EMIT capture_started();
     }
 }
 
 void Capture::stop_capture() {
     s_capture_timer.stop();
+    join_grab_thread();
     // Release the video capture resources
     if (m_video_capture && m_video_capture->isOpened()) {
         m_video_capture->release();
@@ -46,16 +104,91 @@ void Capture::change_camera(int camera) {
     start_capture(camera);
 }
 
+void Capture::change_replay(const QString &file, int pacing) {
+    m_replay_file = file;
+    m_replay_pacing = pacing;
+    change_camera(ReplayCamera::REPLAY_CAMERA);
+}
+
+void Capture::downstream_measured(qint64 interval) {
+    m_downstream_interval = interval;
+}
+
+void Capture::set_adaptive(bool adaptive) {
+    m_adaptive = adaptive;
+}
+
+bool Capture::frame_wanted() {
+    std::int64_t now = ClockTime::monotonic_ns();
+    if (!m_lossless && m_adaptive && now - m_last_frame_time < m_downstream_interval * CAPTURE_ADAPT_HEADROOM / 100) {
+        ++m_skipped;
+        return false;
+    }
+    m_last_frame_time = now;
+    return true;
+}
+
 void Capture::timerEvent(QTimerEvent *ev) {
     if (ev->timerId() != s_capture_timer.timerId()) {
         return;
     }
-    // Grab the frame from the video capture and emit
-    cv::UMat frame;
-    *m_video_capture >> frame;
+    // Do not render a frame the preprocessor is not ready for
+    if (!frame_wanted()) { return; }
+    // Grab the frame from the video capture into a pooled buffer and emit
+    Frame frame;
+    frame.meta.sequence = m_sequence++;
+    frame.meta.enter(FrameMeta::CAPTURE);
+    frame.meta.capture_time = frame.meta.enter_time[FrameMeta::CAPTURE];
+    acquire_frame(frame.image);
+    *m_video_capture >> frame.image;
+    frame.meta.exit(FrameMeta::CAPTURE);
     Q_EMIT frame_ready(frame);
 }
 
+void Capture::join_grab_thread() {
+    m_grabbing = false;
+    // A lossless replay may hold up the grab thread until the preprocessor
+    // frees a slot; let it drop the frame instead
+    if (m_lossless) {
+        m_lossless = false;
+        Q_EMIT lossless_changed(false);
+    }
+    // Wait for the grab thread to finish its current frame
+    if (m_grab_thread.joinable()) { m_grab_thread.join(); }
+}
+
+void Capture::grab_loop() {
+    Frame frame;
+    while (m_grabbing) {
+        // Blocks until the device has exposed the next frame
+        if (!m_video_capture->grab()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(CAPTURE_RETRY_INTERVAL));
+            continue;
+        }
+        // Keep the device's buffer moving but skip decoding a frame
+        // the preprocessor is not ready for
+        if (!frame_wanted()) { continue; }
+        // Stamp the frame as close to the grab as possible
+        frame.meta = FrameMeta();
+        frame.meta.enter(FrameMeta::CAPTURE);
+        frame.meta.capture_time = frame.meta.enter_time[FrameMeta::CAPTURE];
+        acquire_frame(frame.image);
+        if (m_video_capture->retrieve(frame.image)) {
+            frame.meta.sequence = m_sequence++;
+            frame.meta.exit(FrameMeta::CAPTURE);
+            Q_EMIT frame_ready(frame);
+        }
+        // Drop this thread's reference so the buffer can be recycled
+        frame.image.release();
+    }
+}
+
+void Capture::acquire_frame(cv::UMat &frame) {
+    if (m_frame_width > 0 && m_frame_height > 0) {
+        frame = m_pool->acquire({m_frame_width, m_frame_height}, CV_8UC3);
+    }
+}
+
 int Capture::capture_width() const {
     return static_cast<int>(m_video_capture->get(cv::CAP_PROP_FRAME_WIDTH));
 }
@@ -63,3 +196,11 @@ int Capture::capture_width() const {
 int Capture::capture_height() const {
     return static_cast<int>(m_video_capture->get(cv::CAP_PROP_FRAME_HEIGHT));
 }
+
+std::size_t Capture::allocations() const {
+    return m_pool->allocations();
+}
+
+std::size_t Capture::skipped() const {
+    return m_skipped;
+}
@@ -2,39 +2,79 @@
 #define MINOTAUR_CPP_CAPTURE_H
 
 #include <QObject>
+#include <QString>
+#include <atomic>
+#include <cstdint>
 #include <memory>
+#include <thread>
 
 // OpenCV forward declarations
 namespace cv {
     class UMat;
     class VideoCapture;
 }
+class FramePool;
+struct Frame;
 
 /**
  * This object is the beginning of the image pipeline and
  * is responsible for managing the OpenCV Video Capture
  * object that polls frames from the active camera. These frames
  * are emitted to the preprocessor.
+ *
+ * Live cameras are read by a dedicated grab thread that blocks on the
+ * device and so runs at the camera's native frame rate. The FakeCamera,
+ * which never blocks, is polled by a timer instead. Recordings are
+ * replayed through a ReplayCamera on the grab thread.
+ *
+ * The capture adapts its rate to the interval at which the preprocessor
+ * can take frames. Frames that arrive sooner are grabbed but not
+ * retrieved, so they are never decoded only to be dropped downstream.
+ * This is disabled while replaying losslessly.
  */
 class Capture : public QObject {
     Q_OBJECT
 
 public:
     Capture();
+    ~Capture() override;
 
     int capture_width() const;
 
     int capture_height() const;
 
+    /**
+     * @return number of frame buffers allocated by the capture
+     */
+    std::size_t allocations() const;
+
+    /**
+     * @return number of frames grabbed but skipped to match the
+     *         downstream rate; may be read from any thread
+     */
+    std::size_t skipped() const;
+
     Q_SIGNAL void capture_started();
 
     Q_SIGNAL void capture_stopped();
 
     /**
      * Signal emitted when a frame has been received
-     * by the Capture.
+     * by the Capture. May be emitted from the grab thread.
+     *
+     * @param frame the captured frame, stamped with its sequence
+     *              number and monotonic capture time
      */
-    Q_SIGNAL void frame_ready(const cv::UMat &);
+    Q_SIGNAL void frame_ready(const Frame &frame);
+
+    /**
+     * Signal emitted when capture starts with whether downstream stages
+     * should hold up the capture rather than drop frames, which is the
+     * case when replaying a recording as fast as possible.
+     *
+     * @param lossless whether no frame should be dropped
+     */
+    Q_SIGNAL void lossless_changed(bool lossless);
 
     Q_SLOT void start_capture(int cam);
 
@@ -42,13 +82,101 @@ public:
 
     Q_SLOT void change_camera(int camera);
 
+    /**
+     * Replay a recording in place of the camera.
+     *
+     * @param file   path of a session or video file
+     * @param pacing one of the ReplayCamera pacings
+     */
+    Q_SLOT void change_replay(const QString &file, int pacing);
+
+    /**
+     * Set the interval at which the downstream stages can take frames.
+     * This slot is thread-safe and should be called directly.
+     *
+     * @param interval nanoseconds between frames
+     */
+    Q_SLOT void downstream_measured(qint64 interval);
+
+    /**
+     * Set whether the capture skips frames to match the downstream
+     * rate. This slot is thread-safe.
+     *
+     * @param adaptive whether to adapt the capture rate
+     */
+    Q_SLOT void set_adaptive(bool adaptive);
+
 private:
     void timerEvent(QTimerEvent *ev) override;
 
+    /**
+     * Loop run on the grab thread which blocks on the device for each
+     * frame until the capture is stopped.
+     */
+    void grab_loop();
+
+    /**
+     * Stop the grab thread and wait for it, first ending lossless mode so
+     * that a producer waiting for a free slot gives up.
+     */
+    void join_grab_thread();
+
+    /**
+     * Acquire a frame buffer of the capture size.
+     *
+     * @param frame buffer to fill
+     */
+    void acquire_frame(cv::UMat &frame);
+
+    /**
+     * Decide whether a grabbed frame should be retrieved, which is when
+     * enough time has passed since the last one for the downstream stages
+     * to be ready for it.
+     *
+     * @return whether to retrieve the frame
+     */
+    bool frame_wanted();
+
     /**
      * Video Capture instance that produces images.
      */
     std::unique_ptr<cv::VideoCapture> m_video_capture;
+    /**
+     * Pool of frame buffers into which frames are captured.
+     */
+    std::unique_ptr<FramePool> m_pool;
+    /**
+     * Dimensions of the captured frames.
+     */
+    int m_frame_width;
+    int m_frame_height;
+    /**
+     * Sequence number of the next captured frame.
+     */
+    std::uint64_t m_sequence;
+    /**
+     * Thread reading frames from a live camera.
+     */
+    std::thread m_grab_thread;
+    /**
+     * Whether the grab thread should keep running.
+     */
+    std::atomic<bool> m_grabbing;
+    /**
+     * Recording and pacing used when the replay camera is selected.
+     */
+    QString m_replay_file;
+    int m_replay_pacing;
+    /**
+     * Downstream interval between frames, in nanoseconds, and the time
+     * the last frame was retrieved.
+     */
+    std::atomic<std::int64_t> m_downstream_interval;
+    std::int64_t m_last_frame_time;
+    std::atomic<bool> m_adaptive;
+    // Whether every frame must be retrieved, as in a lossless replay
+    std::atomic<bool> m_lossless;
+    std::atomic<std::size_t> m_skipped;
 };
 
 #endif //MINOTAUR_CPP_CAPTURE_H
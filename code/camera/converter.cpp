@@ -1,32 +1,79 @@
 #include <opencv2/imgproc.hpp>
 #include "converter.h"
+#include "frame.h"
+#include "framepool.h"
 #include "imageviewer.h"
+#include "../utility/utility.h"
 
-static void umat_delete(void *mat)
-{ delete static_cast<cv::UMat *>(mat); }
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+// Qt is able to display BGR pixels without a swap
+#define CONVERTER_BGR888
+#endif
 
 Converter::Converter(ImageViewer *image_viewer) :
+    m_frames(0),
     m_scale(1.0),
-    m_image_viewer(image_viewer) {}
+    m_convert_rgb(true),
+    m_image_viewer(image_viewer),
+    m_pool(std::make_unique<FramePool>()) {}
 
-void Converter::process_frame(const cv::UMat &frame) {
-    // Calculate the required scale
-    m_scale = std::min(
-        static_cast<double>(m_image_viewer->width()) / frame.size().width,
-        static_cast<double>(m_image_viewer->height()) / frame.size().height
-    );
-    cv::UMat dst;
-    // Scale the image into dst
-    cv::resize(frame, dst, cv::Size(), m_scale, m_scale, cv::INTER_LINEAR);
-    // Convert to QImage
-    const QImage image(
-        dst.getMat(1).data, dst.cols, dst.rows, static_cast<int>(dst.step),
-        QImage::Format_RGB888, &umat_delete, new cv::UMat(dst)
+Converter::~Converter() = default;
+
+void Converter::process_frame(const Frame &frame) {
+    FrameMeta meta = frame.meta;
+    meta.enter(FrameMeta::CONVERT);
+    const cv::UMat &src = frame.image;
+    // Calculate the required scale; without a viewer the
+    // frame is converted at its own size
+    m_scale = !m_image_viewer ? 1.0 : std::min(
+        static_cast<double>(m_image_viewer->width()) / src.size().width,
+        static_cast<double>(m_image_viewer->height()) / src.size().height
     );
+    cv::Size size(cvRound(src.cols * m_scale), cvRound(src.rows * m_scale));
+    QImage::Format format = QImage::Format_RGB888;
+    bool swap = m_convert_rgb;
+#ifdef CONVERTER_BGR888
+    if (swap) {
+        format = QImage::Format_BGR888;
+        swap = false;
+    }
+#endif
+    cv::UMat dst = src;
+    if (size != src.size()) {
+        // Scale the image into a pooled buffer and swap
+        // the colours of the smaller image in place
+        dst = m_pool->acquire(size, src.type());
+        cv::resize(src, dst, size, 0, 0, cv::INTER_LINEAR);
+        if (swap) { cv::cvtColor(dst, dst, CV_BGR2RGB); }
+    } else if (swap) {
+        dst = m_pool->acquire(size, src.type());
+        cv::cvtColor(src, dst, CV_BGR2RGB);
+    }
+    // Share the pixel buffer with the QImage, which holds
+    // a reference until it is destroyed
+    cv::Mat pixels;
+    QImage image;
+    if (void *pin = m_pool->pin(dst, pixels)) {
+        image = QImage(
+            pixels.data, pixels.cols, pixels.rows, static_cast<int>(pixels.step),
+            format, &FramePool::unpin, pin
+        );
+    } else {
+        // Every pin slot is held by a QImage; fall back to a copy
+        pixels = dst.getMat(cv::ACCESS_READ);
+        image = QImage(
+            pixels.data, pixels.cols, pixels.rows, static_cast<int>(pixels.step), format
+        ).copy();
+    }
     // Increment number of frames processed
     ++m_frames;
     // Emit the image
-    Q_EMIT image_ready(image);
+    meta.exit(FrameMeta::CONVERT);
+    Q_EMIT image_ready(image, meta);
+}
+
+void Converter::convert_rgb(bool convert_rgb) {
+    m_convert_rgb = convert_rgb;
 }
 
 int Converter::get_and_reset_frames() {
@@ -38,3 +85,7 @@ int Converter::get_and_reset_frames() {
 double Converter::get_previous_scale() const {
     return m_scale;
 }
+
+std::size_t Converter::allocations() const {
+    return m_pool->allocations();
+}
@@ -2,37 +2,51 @@
 #define MINOTAUR_CPP_CONVERTER_H
 
 #include <QObject>
+#include <memory>
 
 // Forward declarations
+class FramePool;
 class ImageViewer;
-namespace cv {
-    class UMat;
-}
+struct Frame;
+struct FrameMeta;
 
 /**
  * This object is responsible for taking processed video frames
  * from the image pipeline and convert them to QImage for display
  * on the ImageViewer.
+ *
+ * Frames travel the pipeline in OpenCV's native BGR order. The colour
+ * swap, if Qt cannot display BGR directly, is done here on the scaled
+ * frame, and the QImage shares the pixel buffer by reference count.
  */
 class Converter : public QObject {
 Q_OBJECT
 
 public:
     explicit Converter(ImageViewer *image_viewer);
+    ~Converter() override;
 
     /**
      * Signal emitted when a QImage has been produced.
      *
-     * @param img converted QImage
+     * @param img  converted QImage
+     * @param meta metadata of the frame from which the image was produced
      */
-    Q_SIGNAL void image_ready(const QImage &img);
+    Q_SIGNAL void image_ready(const QImage &img, const FrameMeta &meta);
 
     /**
      * Slot to receive a processed frame to convert.
      *
      * @param frame processed frame to convert
      */
-    Q_SLOT void process_frame(const cv::UMat &frame);
+    Q_SLOT void process_frame(const Frame &frame);
+
+    /**
+     * Set whether frames hold BGR pixels that must be displayed as RGB.
+     *
+     * @param convert_rgb whether to convert colours for display
+     */
+    Q_SLOT void convert_rgb(bool convert_rgb);
 
     /**
      * Grab the number of frames processed since the last time
@@ -50,6 +64,11 @@ public:
      */
     double get_previous_scale() const;
 
+    /**
+     * @return number of frame buffers allocated by the converter
+     */
+    std::size_t allocations() const;
+
 private:
     /**
      * Number of frames processed since last call to get_and_reset_frames().
@@ -60,9 +79,19 @@ private:
      */
     double m_scale;
     /**
-     * Reference to ImageViewer used to poll width and height for scaling.
+     * Whether frames are displayed with red and blue swapped.
+     */
+    bool m_convert_rgb;
+    /**
+     * Reference to ImageViewer used to poll width and height for scaling,
+     * or nullptr to convert frames unscaled.
      */
     ImageViewer *m_image_viewer;
+    /**
+     * Pool of buffers for scaled frames. Buffers are held by the
+     * emitted QImage until it is destroyed.
+     */
+    std::unique_ptr<FramePool> m_pool;
 };
 
 
@@ -0,0 +1,37 @@
+#include "frame.h"
+#include "../utility/clock_time.h"
+
+#include <algorithm>
+
+FrameMeta::FrameMeta() :
+    sequence(0),
+    capture_time(0) {
+    std::fill(enter_time, enter_time + NUM_STAGES, 0);
+    std::fill(exit_time, exit_time + NUM_STAGES, 0);
+}
+
+void FrameMeta::enter(Stage stage) {
+    enter_time[stage] = ClockTime::monotonic_ns();
+}
+
+void FrameMeta::exit(Stage stage) {
+    exit_time[stage] = ClockTime::monotonic_ns();
+}
+
+bool FrameMeta::passed(Stage stage) const {
+    return exit_time[stage] != 0;
+}
+
+std::int64_t FrameMeta::latency(Stage stage) const {
+    return passed(stage) ? exit_time[stage] - capture_time : -1;
+}
+
+annotation_list &FrameMeta::annotate() {
+    if (!annotations) { annotations = std::make_shared<annotation_list>(); }
+    return *annotations;
+}
+
+detection_list &FrameMeta::detected() {
+    if (!detections) { detections = std::make_shared<detection_list>(); }
+    return *detections;
+}
@@ -0,0 +1,96 @@
+#ifndef MINOTAUR_CPP_FRAME_H
+#define MINOTAUR_CPP_FRAME_H
+
+#include <opencv2/core/core.hpp>
+
+#include <QMetaType>
+#include <cstdint>
+#include <memory>
+
+#include "annotation.h"
+#include "../video/detection.h"
+
+/**
+ * Metadata carried with each frame through the image pipeline. Times
+ * are monotonic nanoseconds from ClockTime::monotonic_ns().
+ */
+struct FrameMeta {
+    /**
+     * Pipeline stages for which enter and exit times are recorded.
+     */
+    enum Stage {
+        CAPTURE,
+        PREPROCESS,
+        MODIFY,
+        CONVERT,
+        RECORD,
+        DISPLAY,
+        NUM_STAGES
+    };
+
+    FrameMeta();
+
+    /**
+     * Record the current time as the time the frame entered a stage.
+     *
+     * @param stage pipeline stage
+     */
+    void enter(Stage stage);
+
+    /**
+     * Record the current time as the time the frame left a stage.
+     *
+     * @param stage pipeline stage
+     */
+    void exit(Stage stage);
+
+    /**
+     * @param stage pipeline stage
+     * @return whether the frame has left the stage
+     */
+    bool passed(Stage stage) const;
+
+    /**
+     * @param stage pipeline stage
+     * @return nanoseconds between capture and the frame leaving the stage,
+     *         or -1 if it has not left the stage
+     */
+    std::int64_t latency(Stage stage) const;
+
+    /**
+     * @return the annotations drawn over the frame, created if the frame
+     *         has none. Only the stage processing the frame may add to them.
+     */
+    annotation_list &annotate();
+
+    /**
+     * @return the shapes detected in the frame, created if the frame has
+     *         none. Only the stage processing the frame may add to them.
+     */
+    detection_list &detected();
+
+    // Capture sequence number, starting at zero for each capture
+    std::uint64_t sequence;
+    // Time at which the frame was grabbed from the device
+    std::int64_t capture_time;
+    // Per-stage enter and exit times, zero if not reached
+    std::int64_t enter_time[NUM_STAGES];
+    std::int64_t exit_time[NUM_STAGES];
+    // Shapes drawn over the frame by the display, null if there are none
+    std::shared_ptr<annotation_list> annotations;
+    // Shapes published with the frame once it is processed, null if there are none
+    std::shared_ptr<detection_list> detections;
+};
+
+/**
+ * A frame image with its metadata, passed between the pipeline stages.
+ */
+struct Frame {
+    cv::UMat image;
+    FrameMeta meta;
+};
+
+Q_DECLARE_METATYPE(FrameMeta);
+Q_DECLARE_METATYPE(Frame);
+
+#endif //MINOTAUR_CPP_FRAME_H
@@ -0,0 +1,102 @@
+#include "framegraph.h"
+#include "../utility/threadpool.h"
+
+constexpr std::uint64_t FrameContext::UNORDERED;
+
+FrameGraph::FrameGraph(thread_pool &pool) :
+    m_pool(pool),
+    m_remaining(0),
+    m_posted(0) {}
+
+FrameGraph::~FrameGraph() = default;
+
+FrameGraph::node_id FrameGraph::add_node(const std::string &name, node_fn fn, const std::vector<node_id> &inputs) {
+    node_id id = m_nodes.size();
+    m_nodes.push_back({name, std::move(fn), {}, {}});
+    for (node_id input : inputs) {
+        // Only earlier nodes may be inputs
+        if (input >= id) { continue; }
+        m_nodes[id].inputs.push_back(input);
+        m_nodes[input].outputs.push_back(id);
+    }
+    return id;
+}
+
+void FrameGraph::clear() {
+    m_nodes.clear();
+}
+
+void FrameGraph::run(FrameContext &context) {
+    if (m_nodes.empty()) { return; }
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_pending.resize(m_nodes.size());
+    for (node_id id = 0; id < m_nodes.size(); ++id) {
+        m_pending[id] = m_nodes[id].inputs.size();
+        if (m_pending[id] == 0) { m_ready.push_back(id); }
+    }
+    m_remaining = m_nodes.size();
+    wake(m_ready.size(), context);
+    // Help run nodes until every node has run and every posted task,
+    // which refers to this graph and the context, has finished
+    for (;;) {
+        if (!m_ready.empty()) {
+            drain(lock, context);
+        } else if (m_remaining == 0 && m_posted == 0) {
+            break;
+        } else {
+            m_done.wait(lock);
+        }
+    }
+    std::exception_ptr error = m_error;
+    m_error = nullptr;
+    lock.unlock();
+    if (error) { std::rethrow_exception(error); }
+}
+
+void FrameGraph::drain(std::unique_lock<std::mutex> &lock, FrameContext &context) {
+    while (!m_ready.empty()) {
+        node_id id = m_ready.front();
+        m_ready.pop_front();
+        lock.unlock();
+        std::exception_ptr error;
+        try {
+            m_nodes[id].fn(context);
+        } catch (...) {
+            error = std::current_exception();
+        }
+        lock.lock();
+        if (error && !m_error) { m_error = error; }
+        std::size_t ready = 0;
+        for (node_id output : m_nodes[id].outputs) {
+            if (--m_pending[output] == 0) {
+                m_ready.push_back(output);
+                ++ready;
+            }
+        }
+        wake(ready, context);
+        if (--m_remaining == 0) { m_done.notify_all(); }
+    }
+}
+
+void FrameGraph::wake(std::size_t ready, FrameContext &context) {
+    if (ready < 2) { return; }
+    for (std::size_t i = 1; i < ready; ++i) {
+        ++m_posted;
+        m_pool.post([this, &context] {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            drain(lock, context);
+            --m_posted;
+            m_done.notify_all();
+        });
+    }
+    // Also wake the calling thread of run() in case the pool is busy
+    m_done.notify_all();
+}
+
+std::size_t FrameGraph::size() const {
+    return m_nodes.size();
+}
+
+const std::string &FrameGraph::name(node_id node) const {
+    return m_nodes[node].name;
+}
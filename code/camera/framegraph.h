@@ -0,0 +1,135 @@
+#ifndef MINOTAUR_CPP_FRAMEGRAPH_H
+#define MINOTAUR_CPP_FRAMEGRAPH_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "frame.h"
+
+// Forward declarations
+class ImagePyramid;
+class thread_pool;
+
+/**
+ * Per-frame data passed to each node of a FrameGraph.
+ */
+struct FrameContext {
+    // Ticket of frames processed one at a time
+    static constexpr std::uint64_t UNORDERED = std::numeric_limits<std::uint64_t>::max();
+
+    FrameContext(Frame &frame, ImagePyramid &pyramid, std::uint64_t ticket = UNORDERED) :
+        frame(frame),
+        pyramid(pyramid),
+        ticket(ticket) {}
+
+    Frame &frame;
+    ImagePyramid &pyramid;
+    // Order of the frame among the frames in flight on clones of the
+    // modifier, counted from zero when the clones are made
+    std::uint64_t ticket;
+};
+
+/**
+ * A small dataflow graph of per-frame processing stages. Each node
+ * declares the nodes whose output it takes as input, and runs once
+ * every input node has run. Nodes whose inputs are satisfied run
+ * concurrently on a thread pool, so independent branches such as shape
+ * detection and tracking use separate cores, and a node with several
+ * inputs joins those branches.
+ *
+ * The graph must be built and run from one thread at a time. Nodes that
+ * may run concurrently must not write the same data.
+ */
+class FrameGraph {
+public:
+    typedef std::size_t node_id;
+    typedef std::function<void(FrameContext &)> node_fn;
+
+    /**
+     * @param pool worker threads on which branches run
+     */
+    explicit FrameGraph(thread_pool &pool);
+    ~FrameGraph();
+
+    /**
+     * Add a node to the graph. Nodes may only take earlier nodes as
+     * input, so the graph cannot have cycles.
+     *
+     * @param name   node name, for diagnostics
+     * @param fn     function run on each frame
+     * @param inputs nodes that must run before this one
+     * @return the id of the new node
+     */
+    node_id add_node(const std::string &name, node_fn fn, const std::vector<node_id> &inputs = {});
+
+    /**
+     * Remove every node.
+     */
+    void clear();
+
+    /**
+     * Run every node on a frame and return once all of them have run.
+     * The calling thread runs nodes as well, so chains of nodes do not
+     * switch threads. If a node throws, the remaining nodes still run
+     * and the first exception is rethrown.
+     *
+     * @param context frame to process
+     */
+    void run(FrameContext &context);
+
+    /**
+     * @return number of nodes
+     */
+    std::size_t size() const;
+
+    /**
+     * @param node node id
+     * @return the name of the node
+     */
+    const std::string &name(node_id node) const;
+
+private:
+    struct node {
+        std::string name;
+        node_fn fn;
+        std::vector<node_id> inputs;
+        std::vector<node_id> outputs;
+    };
+
+    /**
+     * Run nodes from the ready queue until it is empty.
+     *
+     * @param lock lock on the mutex, held on entry and exit
+     */
+    void drain(std::unique_lock<std::mutex> &lock, FrameContext &context);
+
+    /**
+     * Post a worker task for every newly ready node beyond the one the
+     * current thread will take. Must be called with the mutex held.
+     *
+     * @param ready number of nodes that became ready
+     */
+    void wake(std::size_t ready, FrameContext &context);
+
+    thread_pool &m_pool;
+    std::vector<node> m_nodes;
+
+    // Run state guarded by the mutex
+    std::mutex m_mutex;
+    std::condition_variable m_done;
+    std::deque<node_id> m_ready;
+    std::vector<std::size_t> m_pending;
+    std::size_t m_remaining;
+    // Worker tasks posted to the pool that have not finished
+    std::size_t m_posted;
+    std::exception_ptr m_error;
+};
+
+#endif //MINOTAUR_CPP_FRAMEGRAPH_H
@@ -0,0 +1,97 @@
+#include "framepool.h"
+
+#include <algorithm>
+#include <atomic>
+
+struct FramePool::pin_slot {
+    // Host mapping held on behalf of a QImage
+    cv::Mat pinned;
+    // The slot array, held while the slot is in use
+    std::shared_ptr<pin_slot> slots;
+    std::atomic<bool> in_use;
+};
+
+/**
+ * A pooled buffer is free when the pool holds the only UMat reference
+ * and no Mat mapping of its data exists.
+ *
+ * @param buffer pooled buffer
+ * @return whether the buffer can be handed out
+ */
+static bool is_free(const cv::UMat &buffer) {
+    return buffer.u &&
+           buffer.u->urefcount == 1 &&
+           buffer.u->refcount == 0;
+}
+
+FramePool::FramePool(std::size_t max_buffers) :
+    m_pins(new pin_slot[max_buffers], std::default_delete<pin_slot[]>()),
+    m_max_buffers(max_buffers),
+    m_allocations(0) {
+    for (std::size_t i = 0; i < m_max_buffers; ++i) {
+        m_pins.get()[i].in_use.store(false, std::memory_order_relaxed);
+    }
+}
+
+// A QImage may outlive the pool; its pin then keeps the slots alive
+// until unpin() releases them
+FramePool::~FramePool() = default;
+
+cv::UMat FramePool::acquire(const cv::Size &size, int type) {
+    for (const cv::UMat &buffer : m_buffers) {
+        if (buffer.size() == size &&
+            buffer.type() == type &&
+            is_free(buffer)) {
+            return buffer;
+        }
+    }
+    ++m_allocations;
+    cv::UMat buffer(size, type);
+    if (m_buffers.size() < m_max_buffers) { m_buffers.push_back(buffer); }
+    return buffer;
+}
+
+void FramePool::reserve(const cv::Size &size, int type, std::size_t count) {
+    std::vector<cv::UMat> held;
+    held.reserve(count);
+    // Holding each acquired buffer forces a distinct allocation
+    for (std::size_t i = 0; i < count; ++i) {
+        held.push_back(acquire(size, type));
+    }
+}
+
+void *FramePool::pin(const cv::UMat &buffer, cv::Mat &pixels) {
+    for (std::size_t i = 0; i < m_max_buffers; ++i) {
+        pin_slot &s = m_pins.get()[i];
+        if (s.in_use.load(std::memory_order_acquire)) { continue; }
+        s.pinned = buffer.getMat(cv::ACCESS_READ);
+        s.slots = m_pins;
+        s.in_use.store(true, std::memory_order_release);
+        pixels = s.pinned;
+        return &s;
+    }
+    return nullptr;
+}
+
+void FramePool::unpin(void *handle) {
+    if (!handle) { return; }
+    pin_slot *s = static_cast<pin_slot *>(handle);
+    s->pinned.release();
+    // Hold the slots until the slot is handed back, as the pool may be
+    // gone; they are freed here if this was the last reference
+    std::shared_ptr<pin_slot> slots = std::move(s->slots);
+    // Only hand the slot back once its header is no longer touched
+    s->in_use.store(false, std::memory_order_release);
+}
+
+void FramePool::clear() {
+    m_buffers.erase(std::remove_if(m_buffers.begin(), m_buffers.end(), is_free), m_buffers.end());
+}
+
+std::size_t FramePool::size() const {
+    return m_buffers.size();
+}
+
+std::size_t FramePool::allocations() const {
+    return m_allocations;
+}
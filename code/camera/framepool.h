@@ -0,0 +1,100 @@
+#ifndef MINOTAUR_CPP_FRAMEPOOL_H
+#define MINOTAUR_CPP_FRAMEPOOL_H
+
+#include <opencv2/core/core.hpp>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+/**
+ * A pool of pre-sized frame buffers keyed by size and type, used to avoid
+ * heap allocations on the image pipeline hot path.
+ *
+ * Buffers are reference counted by OpenCV; the pool keeps one reference to
+ * each buffer it owns and hands out cv::UMat headers to the same data. A
+ * buffer is recycled once every other cv::UMat and cv::Mat referring to it
+ * has been released, whichever thread releases it last.
+ *
+ * Each pipeline stage owns its pool and must only acquire from the thread
+ * the stage runs on.
+ */
+class FramePool {
+public:
+    enum {
+        // Default maximum number of buffers held by a pool
+        DEFAULT_MAX_BUFFERS = 16
+    };
+
+    explicit FramePool(std::size_t max_buffers = DEFAULT_MAX_BUFFERS);
+    ~FramePool();
+
+    /**
+     * Acquire a buffer of the given size and type. A free pooled buffer
+     * is returned if one exists. Otherwise a new buffer is allocated,
+     * and pooled if the pool has not reached its maximum size.
+     *
+     * @param size buffer dimensions
+     * @param type OpenCV matrix type
+     * @return a buffer that no other consumer refers to
+     */
+    cv::UMat acquire(const cv::Size &size, int type);
+
+    /**
+     * Pre-allocate a number of buffers of the given size and type.
+     *
+     * @param size  buffer dimensions
+     * @param type  OpenCV matrix type
+     * @param count number of buffers to allocate
+     */
+    void reserve(const cv::Size &size, int type, std::size_t count);
+
+    /**
+     * Map a buffer to host memory and hold the mapping, and with it a
+     * reference to the buffer, until unpin() is called with the returned
+     * handle. This is used to share a buffer with a QImage without a
+     * heap copy. The buffer need not come from this pool, and the pin
+     * may outlive the pool.
+     *
+     * @param buffer buffer to pin
+     * @param pixels mapped host memory of the buffer
+     * @return pin handle, or nullptr if every pin slot is in use
+     */
+    void *pin(const cv::UMat &buffer, cv::Mat &pixels);
+
+    /**
+     * Release a mapping made with pin(). Signature matches
+     * QImageCleanupFunction and may be called from any thread.
+     *
+     * @param handle pin handle
+     */
+    static void unpin(void *handle);
+
+    /**
+     * Release every buffer that is not currently in use.
+     */
+    void clear();
+
+    /**
+     * @return number of buffers held by the pool
+     */
+    std::size_t size() const;
+
+    /**
+     * @return number of buffer allocations made since construction;
+     *         may be read from any thread
+     */
+    std::size_t allocations() const;
+
+private:
+    struct pin_slot;
+
+    std::vector<cv::UMat> m_buffers;
+    // Fixed array of pin slots, released by unpin() on any thread; each
+    // pin shares ownership of the array so that it outlives the pool
+    std::shared_ptr<pin_slot> m_pins;
+    std::size_t m_max_buffers;
+    std::atomic<std::size_t> m_allocations;
+};
+
+#endif //MINOTAUR_CPP_FRAMEPOOL_H
@@ -5,8 +5,12 @@
 #include "camerathread.h"
 #include "capture.h"
 #include "converter.h"
+#include "frame.h"
+#include "instantreplay.h"
+#include "overlay.h"
 #include "preprocessor.h"
 #include "recorder.h"
+#include "transform.h"
 
 #include "../compstate/compstate.h"
 #include "../compstate/parammanager.h"
@@ -20,12 +24,15 @@
 #include <QBasicTimer>
 #include <QFileDialog>
 #include <QMouseEvent>
+#include <QRubberBand>
+#include <algorithm>
 
 // Static instances of camera threads
 static IThread s_thread_capture;
 static IThread s_thread_preprocessor;
 static IThread s_thread_converter;
 static IThread s_thread_recorder;
+static IThread s_thread_replay;
 
 // Timer fired to increment rotation.
 static QBasicTimer s_rotation_timer;
@@ -43,6 +50,17 @@ static QString color_format(double value, const QString &suffix = "") {
     return QString("<font color=\"#8ae234\">%1%2</font>").arg(value).arg(suffix);
 }
 
+static QString latency_format(const char *label, const latency_window &window) {
+    // Percentiles in milliseconds
+    constexpr double ns_per_ms = 1e6;
+    if (!window.count()) { return QString("%1 -").arg(label); }
+    return QString("%1 %2 / %3 / %4 ms")
+        .arg(label)
+        .arg(window.percentile(50) / ns_per_ms, 0, 'f', 1)
+        .arg(window.percentile(95) / ns_per_ms, 0, 'f', 1)
+        .arg(window.percentile(99) / ns_per_ms, 0, 'f', 1);
+}
+
 ImageViewer::ImageViewer(CameraDisplay *parent) :
     QWidget(parent),
 
@@ -50,18 +68,25 @@ ImageViewer::ImageViewer(CameraDisplay *parent) :
 
     m_grid_display(std::make_unique<GridDisplay>(this, parent)),
 
-    m_capture(std::make_unique<Capture>()),
+    m_overlay(std::make_unique<Overlay>()),
+
     m_preprocessor(std::make_unique<Preprocessor>()),
     m_converter(std::make_unique<Converter>(this)),
     m_recorder(std::make_unique<Recorder>()),
+    m_instant_replay(std::make_unique<InstantReplay>()),
+    m_capture(std::make_unique<Capture>()),
 
-    m_selecting_path(false) {
+    m_selecting_path(false),
+    m_rubber_band(std::make_unique<QRubberBand>(QRubberBand::Rectangle, this)),
+    m_selecting_roi(false) {
 
     ui->setupUi(this);
     // Lower the labels so that they do not block mouse events to the
     // GridDisplay and path selection
     ui->zoom_label->lower();
     ui->fps_label->lower();
+    ui->queue_label->lower();
+    ui->latency_label->lower();
 
     // Opaque paint event used to draw the image
     setAttribute(Qt::WA_OpaquePaintEvent);
@@ -71,30 +96,53 @@ ImageViewer::ImageViewer(CameraDisplay *parent) :
     s_thread_preprocessor.start();
     s_thread_converter.start();
     s_thread_recorder.start();
+    s_thread_replay.start();
     m_capture->moveToThread(&s_thread_capture);
     m_preprocessor->moveToThread(&s_thread_preprocessor);
     m_converter->moveToThread(&s_thread_converter);
     m_recorder->moveToThread(&s_thread_recorder);
+    m_instant_replay->moveToThread(&s_thread_replay);
 
     // Start the framerate update timer
     s_frame_timer.start(FRAMERATE_UPDATE_INTERVAL, this);
 
     // Connect image pipeline
-    connect(m_capture.get(), &Capture::frame_ready, m_preprocessor.get(), &Preprocessor::preprocess_frame);
+    // Frames are pushed into the preprocessor queue directly from the capture thread
+    connect(m_capture.get(), &Capture::frame_ready, m_preprocessor.get(), &Preprocessor::preprocess_frame,
+            Qt::DirectConnection);
     connect(m_preprocessor.get(), &Preprocessor::frame_processed, m_converter.get(), &Converter::process_frame);
-    connect(m_preprocessor.get(), &Preprocessor::frame_processed, m_recorder.get(), &Recorder::frame_received);
+    // Frames are pushed into the bounded encode queue directly from the preprocessor thread
+    connect(m_preprocessor.get(), &Preprocessor::frame_processed, m_recorder.get(), &Recorder::frame_received,
+            Qt::DirectConnection);
+    // Processed frames are copied into the instant replay buffer from the preprocessor thread
+    connect(m_preprocessor.get(), &Preprocessor::frame_processed, m_instant_replay.get(),
+            &InstantReplay::frame_received, Qt::DirectConnection);
+    // Sessions record the captured frames, before any modification
+    connect(m_capture.get(), &Capture::frame_ready, m_recorder.get(), &Recorder::capture_received,
+            Qt::DirectConnection);
+    // The capture skips frames the preprocessor would not be ready for
+    connect(m_preprocessor.get(), &Preprocessor::service_measured, m_capture.get(), &Capture::downstream_measured,
+            Qt::DirectConnection);
+    // A replay run as fast as possible holds up the capture instead of dropping frames
+    connect(m_capture.get(), &Capture::lossless_changed, m_preprocessor.get(), &Preprocessor::set_lossless,
+            Qt::DirectConnection);
     connect(m_converter.get(), &Converter::image_ready, this, &ImageViewer::set_image);
+    // Detections reach the CompetitionState through the camera display
+    connect(m_preprocessor.get(), &Preprocessor::detections_found, parent, &CameraDisplay::detections_found);
 
     // Connect UI signals
+    connect(parent, &CameraDisplay::display_opened, this, &ImageViewer::configure_queue);
     connect(parent, &CameraDisplay::display_opened, m_capture.get(), &Capture::start_capture);
     connect(parent, &CameraDisplay::display_closed, m_capture.get(), &Capture::stop_capture);
     connect(parent, &CameraDisplay::camera_changed, m_capture.get(), &Capture::change_camera);
+    connect(parent, &CameraDisplay::replay_changed, m_capture.get(), &Capture::change_replay);
     connect(parent, &CameraDisplay::effect_changed, m_preprocessor.get(), &Preprocessor::use_modifier);
     connect(parent, &CameraDisplay::zoom_changed, m_preprocessor.get(), &Preprocessor::zoom_changed);
     connect(parent, &CameraDisplay::rotation_changed, m_preprocessor.get(), &Preprocessor::rotation_changed);
     connect(parent, &CameraDisplay::toggle_rotation, this, &ImageViewer::toggle_rotation);
     connect(parent, &CameraDisplay::save_screenshot, this, &ImageViewer::save_screenshot);
     connect(parent, &CameraDisplay::toggle_record, this, &ImageViewer::handle_recording);
+    connect(parent, &CameraDisplay::dump_replay, m_instant_replay.get(), &InstantReplay::dump);
     connect(parent, &CameraDisplay::toggle_path, this, &ImageViewer::toggle_path);
     connect(parent, &CameraDisplay::clear_path, this, &ImageViewer::clear_path);
     connect(parent, &CameraDisplay::zoom_changed, this, &ImageViewer::set_zoom);
@@ -107,6 +155,7 @@ ImageViewer::ImageViewer(CameraDisplay *parent) :
     connect(this, &ImageViewer::increment_rotation, parent, &CameraDisplay::increment_rotation);
     connect(this, &ImageViewer::start_recording, m_recorder.get(), &Recorder::start_recording);
     connect(this, &ImageViewer::stop_recording, m_recorder.get(), &Recorder::stop_recording);
+    connect(m_instant_replay.get(), &InstantReplay::dump_finished, this, &ImageViewer::replay_dumped);
 }
 
 ImageViewer::~ImageViewer() {
@@ -122,10 +171,18 @@ void ImageViewer::add_path_point(double pixel_x, double pixel_y) {
     Main::get()->state().append_path(path_x, path_y);
 }
 
-void ImageViewer::set_image(const QImage &img) {
+void ImageViewer::set_image(const QImage &img, const FrameMeta &meta) {
+    // Record the frame latencies
+    FrameMeta displayed = meta;
+    displayed.exit(FrameMeta::DISPLAY);
+    m_display_latency.add(displayed.latency(FrameMeta::DISPLAY));
+    if (displayed.passed(FrameMeta::MODIFY)) {
+        m_tracker_latency.add(displayed.latency(FrameMeta::MODIFY));
+    }
     // Upon first frame capture, resize the widget
     if (m_image.isNull()) { setFixedSize(img.size()); }
     m_image = img;
+    m_overlay->set_annotations(meta.annotations, m_converter->get_previous_scale());
     // Trigger rerender
     update();
 }
@@ -147,18 +204,70 @@ void ImageViewer::set_path(const std::vector<vector2i> &pixel_path) {
     }
 }
 
+cv::Rect2d ImageViewer::to_frame_rect(const QRect &rect) const {
+    double scale = m_converter->get_previous_scale();
+    // Rotation and zoom keep the frame size
+    cv::Size size(cvRound(m_image.width() / scale), cvRound(m_image.height() / scale));
+    double angle = m_preprocessor->get_rotation_angle();
+    double zoom = m_preprocessor->get_zoom_factor();
+    std::vector<cv::Point2d> corners;
+    for (const QPoint &corner : {rect.topLeft(), rect.topRight(), rect.bottomLeft(), rect.bottomRight()}) {
+        cv::Point2d displayed(corner.x() / scale, corner.y() / scale);
+        corners.push_back(FrameTransform::unmap(displayed, size, angle, zoom));
+    }
+    double left = corners[0].x;
+    double top = corners[0].y;
+    double right = left;
+    double bottom = top;
+    for (const cv::Point2d &corner : corners) {
+        left = std::min(left, corner.x);
+        top = std::min(top, corner.y);
+        right = std::max(right, corner.x);
+        bottom = std::max(bottom, corner.y);
+    }
+    return cv::Rect2d(left, top, right - left, bottom - top);
+}
+
 void ImageViewer::mousePressEvent(QMouseEvent *ev) {
-    if (m_selecting_path) {
+    if (Main::get()->state().roi_request() != CompetitionState::NO_ROI) {
+        // The video keeps playing while the region is dragged out
+        m_selecting_roi = true;
+        m_roi_origin = ev->pos();
+        m_rubber_band->setGeometry(QRect(m_roi_origin, QSize()));
+        m_rubber_band->show();
+    } else if (m_selecting_path) {
         add_path_point(ev->x(), ev->y());
     }
     QWidget::mousePressEvent(ev);
 }
 
+void ImageViewer::mouseMoveEvent(QMouseEvent *ev) {
+    if (m_selecting_roi) {
+        m_rubber_band->setGeometry(QRect(m_roi_origin, ev->pos()).normalized());
+    }
+    QWidget::mouseMoveEvent(ev);
+}
+
+void ImageViewer::mouseReleaseEvent(QMouseEvent *ev) {
+    if (m_selecting_roi) {
+        m_selecting_roi = false;
+        m_rubber_band->hide();
+        QRect roi = QRect(m_roi_origin, ev->pos()).normalized() & rect();
+        // A click without a drag selects nothing
+        if (roi.width() > 1 && roi.height() > 1 && !m_image.isNull()) {
+            Main::get()->state().select_roi(to_frame_rect(roi));
+        }
+    }
+    QWidget::mouseReleaseEvent(ev);
+}
+
 void ImageViewer::timerEvent(QTimerEvent *ev) {
     if (ev->timerId() == s_frame_timer.timerId()) {
         int frames = m_converter->get_and_reset_frames();
         double fps = 1000.0 * frames / FRAMERATE_UPDATE_INTERVAL;
         set_frame_rate(fps);
+        set_latency();
+        set_queue_stats();
     } else if (ev->timerId() == s_rotation_timer.timerId()) {
         Q_EMIT increment_rotation();
     }
@@ -169,28 +278,15 @@ void ImageViewer::paintEvent(QPaintEvent *) {
     // Draw the image first
     painter.drawImage(0, 0, m_image);
     painter.setRenderHint(QPainter::Antialiasing);
-    // Need to rescale the path nodes
+    // The path layer is only redrawn when the path or its scale changes
     double combined_scale =
         m_preprocessor->get_zoom_factor() *
         m_converter->get_previous_scale();
-    const path2d &path = Main::get()->state().get_path();
-    for (std::size_t i = 0; i < path.size(); ++i) {
-        // Draw each node and connect lines between them
-        QColor color;
-        // Color based on start and end
-        if (i == 0) { color = Qt::red; }
-        else if (i + 1 == path.size()) { color = Qt::blue; }
-        else { color = Qt::green; }
-        vector2i v1 = path[i] * combined_scale;
-        painter.setBrush(color);
-        painter.setPen(color);
-        painter.drawEllipse(v1.x() - 4, v1.y() - 4, 8, 8);
-        if (i > 0) {
-            vector2i v0 = path[i - 1] * combined_scale;
-            painter.setPen(QPen(Qt::green, 2, Qt::DashDotLine, Qt::RoundCap));
-            painter.drawLine(v0.x(), v0.y(), v1.x(), v1.y());
-        }
+    const CompetitionState &state = Main::get()->state();
+    if (m_overlay->path_stale(state.path_revision(), combined_scale, size())) {
+        m_overlay->set_path(state.get_path(), state.path_revision(), combined_scale, size());
     }
+    m_overlay->paint(painter);
     painter.end();
 }
 
@@ -198,6 +294,36 @@ void ImageViewer::set_frame_rate(double frame_rate) {
     ui->fps_label->setText(color_format(frame_rate));
 }
 
+void ImageViewer::set_latency() {
+    ui->latency_label->setText(QString("<font color=\"#8ae234\">%1<br>%2</font>")
+        .arg(latency_format("disp", m_display_latency))
+        .arg(latency_format("trk", m_tracker_latency)));
+}
+
+void ImageViewer::set_queue_stats() {
+    ring_buffer_stats stats = m_preprocessor->queue_stats();
+    QString text = QString("%1 / %2 / %3").arg(stats.enqueued).arg(stats.dropped).arg(stats.processed);
+    // Frames the capture did not decode to match the preprocessor's rate
+    text += QString("<br>cap %1 skipped").arg(m_capture->skipped());
+    if (m_recorder->is_recording()) {
+        // Frames waiting to be encoded and frames lost to the encode queue
+        ring_buffer_stats record_stats = m_recorder->queue_stats();
+        text += QString("<br>rec %1 queued / %2 dropped").arg(m_recorder->queued()).arg(record_stats.dropped);
+    }
+    ui->queue_label->setText(QString("<font color=\"#8ae234\">%1</font>").arg(text));
+}
+
+void ImageViewer::configure_queue() {
+    if (!g_pm) { return; }
+    m_preprocessor->set_queue_policy(g_pm->frame_queue_policy, g_pm->frame_queue_slots);
+    m_recorder->set_queue_policy(g_pm->record_queue_policy, g_pm->record_queue_slots);
+    m_capture->set_adaptive(g_pm->adaptive_capture != 0);
+    m_instant_replay->configure(g_pm->replay_buffer_mb, g_pm->replay_buffer_seconds);
+    // The lanes are rebuilt on the preprocessor thread
+    QMetaObject::invokeMethod(m_preprocessor.get(), "set_frames_in_flight", Qt::QueuedConnection,
+                              Q_ARG(int, g_pm->frames_in_flight));
+}
+
 void ImageViewer::set_zoom(double zoom) {
     ui->zoom_label->setText(color_format(zoom, "x"));
     m_preprocessor->zoom_changed(zoom);
@@ -213,12 +339,21 @@ void ImageViewer::handle_recording() {
         Q_EMIT stop_recording();
     } else {
         // Grab the video save path and start recording
-        QString file = QFileDialog::getSaveFileName(this, "Save Video", QDir::currentPath(), "Videos (*.avi)");
+        QString file = QFileDialog::getSaveFileName(this, "Save Video", QDir::currentPath(),
+                                                    "Videos (*.avi);;Sessions (*.session)");
         log() << "Saving video to: " << file;
         Q_EMIT start_recording(file, m_capture->capture_width(), m_capture->capture_height());
     }
 }
 
+void ImageViewer::replay_dumped(const QString &file, int frames) {
+    if (frames < 0) {
+        log() << "Could not save replay to: " << file;
+    } else {
+        log() << "Saved " << frames << " replay frames to: " << file;
+    }
+}
+
 void ImageViewer::toggle_path(bool toggle_path) {
     m_selecting_path = toggle_path;
 }
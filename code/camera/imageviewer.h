@@ -1,14 +1,22 @@
 #ifndef MINOTAUR_CPP_IMAGEVIEWER_H_H
 #define MINOTAUR_CPP_IMAGEVIEWER_H_H
 
+#include <QPoint>
 #include <QWidget>
 #include <memory>
 
+#include "../utility/latency.h"
+
 // Forward declarations
 namespace Ui {
     class ImageViewer;
 }
 class QPaintEvent;
+class QRubberBand;
+namespace cv {
+    template<typename _Tp> class Rect_;
+    typedef Rect_<double> Rect2d;
+}
 namespace nrg {
     template<typename val_t> class vector;
 }
@@ -18,6 +26,9 @@ class Capture;
 class Preprocessor;
 class Converter;
 class Recorder;
+class InstantReplay;
+class Overlay;
+struct FrameMeta;
 typedef nrg::vector<int> vector2i;
 
 /**
@@ -52,14 +63,26 @@ public:
      */
     void set_path(const std::vector<vector2i> &pixel_path);
 
+    /**
+     * Convert a rectangle on the ImageViewer to frame coordinates, as
+     * seen by the video modifiers, undoing the display scale and the
+     * rotation and zoom of the frame.
+     *
+     * @param rect rectangle in ImageViewer pixels
+     * @return the bounding box of the rectangle in frame pixels
+     */
+    cv::Rect2d to_frame_rect(const QRect &rect) const;
+
 public:
     /**
      * Set the image that is displayed by the image viewer. This slot is
-     * called with a newly converted QImage from Converter
+     * called with a newly converted QImage from Converter. The frame
+     * latencies are recorded from the metadata.
      *
-     * @param img frame image to display
+     * @param img  frame image to display
+     * @param meta metadata of the displayed frame
      */
-    Q_SLOT void set_image(const QImage &img);
+    Q_SLOT void set_image(const QImage &img, const FrameMeta &meta);
 
     /**
      * Set the frame rate value that is displayed in the frame rate
@@ -69,6 +92,26 @@ public:
      */
     Q_SLOT void set_frame_rate(double frame_rate);
 
+    /**
+     * Display the p50, p95, and p99 capture-to-display and
+     * capture-to-tracker-output latencies.
+     */
+    void set_latency();
+
+    /**
+     * Display the preprocessor queue counters as enqueued, dropped,
+     * and processed frames and, while recording, the number of frames
+     * queued for encoding and dropped by the recorder.
+     */
+    void set_queue_stats();
+
+    /**
+     * Slot called when the display opens to apply the frame and encode
+     * queue policies and sizes, the number of frames in flight, and the
+     * instant replay budget from the parameter manager to the pipeline.
+     */
+    Q_SLOT void configure_queue();
+
     /**
      * Set the zoom value displayed in the zoom indicator and forward
      * the value to the preprocessor.
@@ -85,6 +128,14 @@ public:
      */
     Q_SLOT void save_screenshot(const QString &file);
 
+    /**
+     * Slot called when the instant replay buffer has been written.
+     *
+     * @param file   path of the session file
+     * @param frames number of frames written, or -1 on failure
+     */
+    Q_SLOT void replay_dumped(const QString &file, int frames);
+
     /**
      * Slot called to toggle recording.
      */
@@ -135,12 +186,27 @@ public:
 
 private:
     /**
-     * Handle mouse click events to add to the path.
+     * Handle mouse click events to add to the path, or to start a region
+     * of interest when a tracker is waiting for one.
      *
      * @param ev mouse event
      */
     void mousePressEvent(QMouseEvent *ev) override;
 
+    /**
+     * Stretch the region of interest being selected.
+     *
+     * @param ev mouse event
+     */
+    void mouseMoveEvent(QMouseEvent *ev) override;
+
+    /**
+     * Hand the selected region of interest to the CompetitionState.
+     *
+     * @param ev mouse event
+     */
+    void mouseReleaseEvent(QMouseEvent *ev) override;
+
     /**
      * Handle the framerate and rotation timers.
      *
@@ -149,7 +215,7 @@ private:
     void timerEvent(QTimerEvent *ev) override;
 
     /**
-     * Paint event should draw the QImage and the paths.
+     * Paint event should draw the QImage and the overlay.
      *
      * @param ev paint event
      */
@@ -164,17 +230,43 @@ private:
      * The currently displayed image.
      */
     QImage m_image;
+    /**
+     * Path and frame annotations drawn over the image.
+     */
+    std::unique_ptr<Overlay> m_overlay;
 
     // Pipeline elements
-    std::unique_ptr<Capture> m_capture;
     std::unique_ptr<Preprocessor> m_preprocessor;
     std::unique_ptr<Converter> m_converter;
     std::unique_ptr<Recorder> m_recorder;
+    std::unique_ptr<InstantReplay> m_instant_replay;
+    /**
+     * Declared last so that it is destroyed first: its grab thread calls
+     * into the preprocessor and recorder until the capture joins it.
+     */
+    std::unique_ptr<Capture> m_capture;
+
+    /**
+     * Recent capture-to-display latencies.
+     */
+    latency_window m_display_latency;
+    /**
+     * Recent capture-to-tracker-output latencies, measured when the
+     * frame leaves the video modifier.
+     */
+    latency_window m_tracker_latency;
 
     /**
      * Whether mouse events should be handled to add path nodes.
      */
     bool m_selecting_path;
+
+    /**
+     * Region of interest being dragged out, and where the drag began.
+     */
+    std::unique_ptr<QRubberBand> m_rubber_band;
+    QPoint m_roi_origin;
+    bool m_selecting_roi;
 };
 
 #endif //MINOTAUR_CPP_IMAGEVIEWER_H_H
@@ -0,0 +1,146 @@
+#include <algorithm>
+
+#include "instantreplay.h"
+#include "session.h"
+
+static std::size_t buffer_bytes(const cv::Size &size, int type) {
+    return static_cast<std::size_t>(size.area()) * CV_ELEM_SIZE(type);
+}
+
+static std::size_t buffer_bytes(const cv::Mat &buffer) {
+    return buffer.total() * buffer.elemSize();
+}
+
+InstantReplay::InstantReplay(std::size_t budget_mb, int seconds) :
+    m_head(0),
+    m_count(0),
+    m_allocated(0),
+    m_budget(budget_mb * 1024 * 1024),
+    m_seconds(seconds),
+    m_type(-1),
+    m_missed(0) {}
+
+InstantReplay::~InstantReplay() = default;
+
+void InstantReplay::frame_received(const Frame &frame) {
+    cv::Mat image = frame.image.getMat(cv::ACCESS_READ);
+    cv::Mat buffer;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (image.size() != m_size || image.type() != m_type) {
+            // Drop the frames of the old size and size the ring to
+            // the number of frames that fit in the budget
+            for (const entry &e : m_frames) { m_allocated -= buffer_bytes(e.image); }
+            for (const cv::Mat &free : m_free) { m_allocated -= buffer_bytes(free); }
+            m_free.clear();
+            m_size = image.size();
+            m_type = image.type();
+            std::size_t slots = m_budget / std::max<std::size_t>(buffer_bytes(m_size, m_type), 1);
+            m_frames.assign(std::max<std::size_t>(slots, 1), entry());
+            m_head = 0;
+            m_count = 0;
+        }
+        buffer = take_buffer(m_size, m_type);
+    }
+    if (buffer.empty()) {
+        ++m_missed;
+        return;
+    }
+    // Copy without the lock; the buffer is not shared until it is added
+    image.copyTo(buffer);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (buffer.size() != m_size || buffer.type() != m_type) {
+        // Reconfigured while copying
+        m_allocated -= buffer_bytes(buffer);
+        return;
+    }
+    entry &e = m_frames[(m_head + m_count) % m_frames.size()];
+    e.image = buffer;
+    e.meta = frame.meta;
+    ++m_count;
+}
+
+cv::Mat InstantReplay::take_buffer(const cv::Size &size, int type) {
+    cv::Mat buffer;
+    if (!m_free.empty()) {
+        buffer = m_free.back();
+        m_free.pop_back();
+        return buffer;
+    }
+    std::size_t bytes = buffer_bytes(size, type);
+    if (m_allocated + bytes <= m_budget || m_allocated == 0) {
+        m_allocated += bytes;
+        buffer.create(size, type);
+        return buffer;
+    }
+    if (m_count > 0) {
+        // Reuse the oldest frame's buffer
+        entry &oldest = m_frames[m_head];
+        buffer = oldest.image;
+        oldest.image = cv::Mat();
+        m_head = (m_head + 1) % m_frames.size();
+        --m_count;
+    }
+    return buffer;
+}
+
+void InstantReplay::return_buffer(cv::Mat &buffer) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (buffer.size() == m_size && buffer.type() == m_type && m_allocated <= m_budget) {
+        m_free.push_back(buffer);
+    } else {
+        // The frame size or budget has changed since the buffer was taken
+        m_allocated -= buffer_bytes(buffer);
+    }
+    buffer = cv::Mat();
+}
+
+void InstantReplay::dump(const QString &file) {
+    std::vector<entry> frames;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_count > 0) {
+            std::size_t slots = m_frames.size();
+            std::int64_t newest = m_frames[(m_head + m_count - 1) % slots].meta.capture_time;
+            std::int64_t oldest = newest - m_seconds * 1000000000;
+            // Move the frames of the last seconds out of the ring, oldest
+            // first; older frames stay until their buffers are reused
+            std::size_t keep = 0;
+            while (keep < m_count && m_frames[(m_head + keep) % slots].meta.capture_time < oldest) { ++keep; }
+            for (std::size_t i = keep; i < m_count; ++i) {
+                entry &e = m_frames[(m_head + i) % slots];
+                frames.push_back(e);
+                e.image = cv::Mat();
+            }
+            m_count = keep;
+        }
+    }
+    QString path = file.endsWith(session::EXTENSION) ? file : file + session::EXTENSION;
+    SessionWriter writer;
+    bool opened = writer.open(path);
+    for (entry &e : frames) {
+        if (opened) { writer.write(e.image, e.meta); }
+        // The pipeline may reuse the buffer as soon as it is written
+        return_buffer(e.image);
+    }
+    writer.close();
+    Q_EMIT dump_finished(path, opened ? static_cast<int>(frames.size()) : -1);
+}
+
+void InstantReplay::configure(int budget_mb, int seconds) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_budget = static_cast<std::size_t>(std::max(budget_mb, 0)) * 1024 * 1024;
+    m_seconds = seconds;
+    // Resize the ring on the next frame
+    m_size = cv::Size();
+    m_type = -1;
+}
+
+std::size_t InstantReplay::size() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_count;
+}
+
+std::size_t InstantReplay::missed() const {
+    return m_missed;
+}
@@ -0,0 +1,130 @@
+#ifndef MINOTAUR_CPP_INSTANTREPLAY_H
+#define MINOTAUR_CPP_INSTANTREPLAY_H
+
+#include <opencv2/core/core.hpp>
+
+#include <QObject>
+#include <QString>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "frame.h"
+
+/**
+ * Always-on buffer of the most recent preprocessed frames, which can be
+ * dumped to a session file after something has gone wrong, without having
+ * started the Recorder beforehand.
+ *
+ * Frames are copied as they are into buffers drawn from a fixed memory
+ * budget, so the live pipeline pays one copy per frame and never encodes.
+ * Once the budget is used up, the oldest frame's buffer is reused. A dump
+ * moves the frames of the last few seconds out of the buffer and writes
+ * them on the thread of this object, returning each buffer to the pool as
+ * soon as its frame has been written.
+ */
+class InstantReplay : public QObject {
+Q_OBJECT
+
+public:
+    enum {
+        // Memory budget for frame buffers, in megabytes
+        DEFAULT_BUDGET_MB = 256,
+        // Seconds of frames written by a dump
+        DEFAULT_SECONDS = 10
+    };
+
+    explicit InstantReplay(
+        std::size_t budget_mb = DEFAULT_BUDGET_MB,
+        int seconds = DEFAULT_SECONDS
+    );
+    ~InstantReplay() override;
+
+    /**
+     * Keep a copy of a processed frame. This slot is thread-safe and
+     * should be called directly from the producer thread.
+     *
+     * @param frame processed frame
+     */
+    Q_SLOT void frame_received(const Frame &frame);
+
+    /**
+     * Write the frames of the last few seconds to a session file. This
+     * slot should be invoked on the thread of this object.
+     *
+     * @param file path of the session file
+     */
+    Q_SLOT void dump(const QString &file);
+
+    /**
+     * Set the memory budget and the seconds written by a dump. Frames
+     * currently buffered are discarded. This slot is thread-safe.
+     *
+     * @param budget_mb memory budget in megabytes
+     * @param seconds   seconds of frames written by a dump
+     */
+    Q_SLOT void configure(int budget_mb, int seconds);
+
+    /**
+     * Signal emitted when a dump has been written.
+     *
+     * @param file   path of the session file
+     * @param frames number of frames written, or -1 if the file
+     *               could not be written
+     */
+    Q_SIGNAL void dump_finished(const QString &file, int frames);
+
+    /**
+     * @return number of frames buffered
+     */
+    std::size_t size() const;
+
+    /**
+     * @return number of frames not kept because every buffer was
+     *         held by a dump
+     */
+    std::size_t missed() const;
+
+private:
+    struct entry {
+        cv::Mat image;
+        FrameMeta meta;
+    };
+
+    /**
+     * Take a buffer for a frame of the given size and type, reusing a
+     * free buffer or the oldest frame's, or allocating one within the
+     * budget. Must be called with the mutex held.
+     *
+     * @param size frame size
+     * @param type frame type
+     * @return the buffer, or an empty Mat if none is available
+     */
+    cv::Mat take_buffer(const cv::Size &size, int type);
+
+    /**
+     * Return a buffer that is no longer used by a dump.
+     *
+     * @param buffer buffer to return
+     */
+    void return_buffer(cv::Mat &buffer);
+
+    mutable std::mutex m_mutex;
+    // Buffered frames as a ring, oldest at the head
+    std::vector<entry> m_frames;
+    std::size_t m_head;
+    std::size_t m_count;
+    // Buffers not holding a frame
+    std::vector<cv::Mat> m_free;
+    // Bytes held by all buffers, including those being dumped
+    std::size_t m_allocated;
+    std::size_t m_budget;
+    std::int64_t m_seconds;
+    // Size and type of the buffered frames
+    cv::Size m_size;
+    int m_type;
+    std::atomic<std::size_t> m_missed;
+};
+
+#endif //MINOTAUR_CPP_INSTANTREPLAY_H
@@ -0,0 +1,77 @@
+#include <QPainter>
+#include <algorithm>
+
+#include "overlay.h"
+#include "../utility/vector.h"
+
+// Radius of the drawn path nodes in display pixels
+static constexpr int NODE_RADIUS = 4;
+
+Overlay::Overlay() :
+    m_path_valid(false),
+    m_path_revision(0),
+    m_path_scale(0.0) {}
+
+bool Overlay::path_stale(std::uint64_t revision, double scale, const QSize &size) const {
+    return !m_path_valid || revision != m_path_revision || scale != m_path_scale || size != m_path_layer.size();
+}
+
+void Overlay::set_path(const path2d &path, std::uint64_t revision, double scale, const QSize &size) {
+    m_path_valid = true;
+    m_path_revision = revision;
+    m_path_scale = scale;
+    if (m_path_layer.size() != size) { m_path_layer = QPixmap(size); }
+    m_path_layer.fill(Qt::transparent);
+    if (path.empty() || size.isEmpty()) { return; }
+    QPainter painter(&m_path_layer);
+    painter.setRenderHint(QPainter::Antialiasing);
+    // Connect the nodes with dashed lines first
+    QPainterPath lines;
+    for (std::size_t i = 0; i < path.size(); ++i) {
+        QPointF point(path[i].x() * scale, path[i].y() * scale);
+        if (i == 0) { lines.moveTo(point); }
+        else { lines.lineTo(point); }
+    }
+    painter.strokePath(lines, QPen(Qt::green, 2, Qt::DashDotLine, Qt::RoundCap));
+    for (std::size_t i = 0; i < path.size(); ++i) {
+        // Color based on start and end
+        QColor color;
+        if (i == 0) { color = Qt::red; }
+        else if (i + 1 == path.size()) { color = Qt::blue; }
+        else { color = Qt::green; }
+        painter.setBrush(color);
+        painter.setPen(color);
+        painter.drawEllipse(QPointF(path[i].x() * scale, path[i].y() * scale), NODE_RADIUS, NODE_RADIUS);
+    }
+}
+
+void Overlay::set_annotations(const std::shared_ptr<annotation_list> &annotations, double scale) {
+    m_shapes.clear();
+    if (!annotations) { return; }
+    for (const Annotation &annotation : *annotations) {
+        shape s;
+        for (const cv::Point &p : annotation.outline) { s.outline << QPointF(p.x * scale, p.y * scale); }
+        // Annotation colours are BGR
+        QColor color(static_cast<int>(annotation.color[2]), static_cast<int>(annotation.color[1]),
+                     static_cast<int>(annotation.color[0]));
+        s.pen = QPen(color, std::max(1.0, annotation.thickness * scale));
+        s.label = QString::fromStdString(annotation.label);
+        m_shapes.push_back(std::move(s));
+    }
+}
+
+void Overlay::paint(QPainter &painter) const {
+    painter.setBrush(Qt::NoBrush);
+    for (const shape &s : m_shapes) {
+        painter.setPen(s.pen);
+        painter.drawPolygon(s.outline);
+        if (s.label.isEmpty()) { continue; }
+        // Label the center of the shape on a white background
+        QRectF text = painter.fontMetrics().boundingRect(s.label);
+        text.moveCenter(s.outline.boundingRect().center());
+        painter.fillRect(text, Qt::white);
+        painter.setPen(Qt::black);
+        painter.drawText(text, Qt::AlignCenter, s.label);
+    }
+    painter.drawPixmap(0, 0, m_path_layer);
+}
@@ -0,0 +1,83 @@
+#ifndef MINOTAUR_CPP_OVERLAY_H
+#define MINOTAUR_CPP_OVERLAY_H
+
+#include <QPainterPath>
+#include <QPen>
+#include <QPixmap>
+#include <QPolygonF>
+#include <QString>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "annotation.h"
+
+// Forward declarations
+class QPainter;
+namespace nrg {
+    template<typename val_t> class vector;
+}
+typedef std::vector<nrg::vector<double>> path2d;
+
+/**
+ * Retained layer drawn by the ImageViewer over the displayed frame, made
+ * of the CompetitionState path and the annotations of the frame.
+ *
+ * The path is rendered into a cached pixmap that is only rebuilt when the
+ * path, the display scale, or the widget size changes, so repaints do not
+ * read the path or redraw each node. Annotations are scaled to display
+ * coordinates once per frame rather than on each repaint.
+ */
+class Overlay {
+public:
+    Overlay();
+
+    /**
+     * @param revision revision of the path, see CompetitionState::path_revision()
+     * @param scale    display pixels per path unit
+     * @param size     size of the layer in display pixels
+     * @return whether the path layer must be rebuilt with set_path()
+     */
+    bool path_stale(std::uint64_t revision, double scale, const QSize &size) const;
+
+    /**
+     * Rebuild the path layer.
+     *
+     * @param path     path in path units
+     * @param revision revision of the path
+     * @param scale    display pixels per path unit
+     * @param size     size of the layer in display pixels
+     */
+    void set_path(const path2d &path, std::uint64_t revision, double scale, const QSize &size);
+
+    /**
+     * Set the annotations of the displayed frame.
+     *
+     * @param annotations frame annotations, or null if there are none
+     * @param scale       display pixels per frame pixel
+     */
+    void set_annotations(const std::shared_ptr<annotation_list> &annotations, double scale);
+
+    /**
+     * Draw the overlay over the frame.
+     *
+     * @param painter painter of the ImageViewer
+     */
+    void paint(QPainter &painter) const;
+
+private:
+    struct shape {
+        QPolygonF outline;
+        QPen pen;
+        QString label;
+    };
+
+    QPixmap m_path_layer;
+    bool m_path_valid;
+    std::uint64_t m_path_revision;
+    double m_path_scale;
+
+    std::vector<shape> m_shapes;
+};
+
+#endif //MINOTAUR_CPP_OVERLAY_H
@@ -1,66 +1,108 @@
 #include <opencv2/imgproc.hpp>
 #include <opencv2/videoio.hpp>
-#include <QBasicTimer>
-#include <QTimerEvent>
 
+#include <algorithm>
+#include <chrono>
+
+#include "frame.h"
+#include "framegraph.h"
+#include "framepool.h"
 #include "preprocessor.h"
+#include "transform.h"
 #include "../video/modify.h"
+#include "../video/pyramid.h"
+#include "../utility/threadpool.h"
 
-// Static timer instance for queue filling
-static QBasicTimer s_queue_timer;
-// Static instance of queue'd frame
-static cv::UMat s_frame;
-
-static void zoom(cv::UMat &src, cv::UMat &dest, double zoom_factor) {
-    // Crop the image to the zoom area
-    cv::Rect crop(
-        static_cast<int>(src.size().width / 2.0 - src.size().width / (2.0 * zoom_factor)),
-        static_cast<int>(src.size().height / 2.0 - src.size().height / (2.0 * zoom_factor)),
-        static_cast<int>(src.size().width / zoom_factor),
-        static_cast<int>(src.size().height / zoom_factor)
-    );
-    src = src(crop);
-    // Resize the image up to the original size
-    cv::resize(src, dest, cv::Size(), zoom_factor, zoom_factor, cv::INTER_LINEAR);
-}
+/**
+ * State for processing one frame at a time. Lanes other than the first
+ * hold clones of the modifier, which share its motion gate.
+ */
+struct PreprocessorLane {
+    PreprocessorLane(thread_pool &workers, std::shared_ptr<VideoModifier> modifier) :
+        modifier(std::move(modifier)),
+        graph(workers),
+        rotation_angle(0),
+        zoom_factor(1.0),
+        busy(false) {}
 
-static void rotate(cv::UMat& src, double angle, cv::UMat& dst) {
-    // Rotate the image
-    cv::Point2f pt_cp(src.cols * 0.5f, src.rows * 0.5f);
-    cv::Mat mat = cv::getRotationMatrix2D(pt_cp, angle, 1.0);
-    cv::warpAffine(src, dst, mat, src.size(), cv::INTER_CUBIC);
-}
+    std::shared_ptr<VideoModifier> modifier;
+    // Pool of buffers for the rotated and zoomed frames
+    FramePool pool;
+    // Fused rotation and zoom with cached remap tables
+    FrameTransform transform;
+    // Pyramid of the current frame shared by the modifiers
+    ImagePyramid pyramid;
+    // Modifier and transform stages
+    FrameGraph graph;
+    // Rotation and zoom applied to the frame being processed
+    int rotation_angle;
+    double zoom_factor;
+    bool busy;
+};
 
 struct PreprocessorDelegate {
     /**
-     * Delegate function with a copied cv::UMat pointer.
+     * Delegate function with a copied frame.
      * Needed since some OpenCV functions do not accept const references
      * and Qt cannot handle non-const reference to Mat as a metatype.
      *
+     * @param lane  lane on which to process the frame
      * @param frame frame to preprocess
      */
-    static void preprocess_frame_delegate(Preprocessor *pp, cv::UMat frame);
+    static void preprocess_frame_delegate(Preprocessor *pp, PreprocessorLane &lane, Frame frame);
+
+    /**
+     * Run the frame graph of a lane on a frame.
+     *
+     * @param lane   lane on which to process the frame
+     * @param frame  frame to preprocess
+     * @param ticket order of the frame among those in flight, or
+     *               FrameContext::UNORDERED on a single lane
+     */
+    static void process(PreprocessorLane &lane, Frame &frame, std::uint64_t ticket);
 };
 
-void PreprocessorDelegate::preprocess_frame_delegate(Preprocessor *pp, cv::UMat frame) {
-    // Modifier frame
-    if (pp->m_modifier) { pp->m_modifier->modify(frame); }
-    // Rotate frame
-    rotate(frame, static_cast<double>(pp->m_rotation_angle), frame);
-    // Frame zoom
-    zoom(frame, frame, pp->m_zoom_factor);
-    // Convert to RGB
-    if (pp->m_convert_rgb) { cv::cvtColor(frame, frame, CV_BGR2RGB); }
+void PreprocessorDelegate::preprocess_frame_delegate(Preprocessor *pp, PreprocessorLane &lane, Frame frame) {
+    lane.rotation_angle = pp->m_rotation_angle;
+    lane.zoom_factor = pp->m_zoom_factor;
+    process(lane, frame, FrameContext::UNORDERED);
     // Emit preprocessed frame
-    Q_EMIT pp->frame_processed(frame);
+    pp->publish(frame);
+}
+
+void PreprocessorDelegate::process(PreprocessorLane &lane, Frame &frame, std::uint64_t ticket) {
+    frame.meta.enter(FrameMeta::PREPROCESS);
+    // Run the modifier and transform stages of the frame graph
+    lane.pyramid.reset(frame.image);
+    FrameContext context(frame, lane.pyramid, ticket);
+    lane.graph.run(context);
+    // Drop the pyramid's reference so the frame buffer can be recycled
+    lane.pyramid.release();
+    frame.meta.exit(FrameMeta::PREPROCESS);
 }
 
 
 Preprocessor::Preprocessor() :
+    m_workers(std::make_unique<thread_pool>(BRANCH_WORKERS)),
+    m_frames_in_flight(DEFAULT_FRAMES_IN_FLIGHT),
+    m_next_ticket(0),
+    m_emitting(false),
+    m_retired_allocations(0),
+    m_service_time(0),
+    m_queue(std::make_shared<frame_queue>(
+        DEFAULT_QUEUE_SLOTS,
+        static_cast<frame_queue::Policy>(DEFAULT_QUEUE_POLICY))),
+    m_draining(false),
+    m_lossless(false),
     m_zoom_factor(1.0),
-    m_rotation_angle(0),
-    m_convert_rgb(true),
-    m_process_all(false) {}
+    m_rotation_angle(0) {
+    build_lanes();
+}
+
+Preprocessor::~Preprocessor() {
+    // Finish the frames in flight while the lanes still exist
+    m_frame_workers.reset();
+}
 
 void Preprocessor::zoom_changed(double zoom_factor) {
     m_zoom_factor = zoom_factor;
@@ -70,41 +112,223 @@ void Preprocessor::rotation_changed(int angle) {
     m_rotation_angle = angle;
 }
 
-void Preprocessor::convert_rgb(bool convert_rgb) {
-    m_convert_rgb = convert_rgb;
-}
-
 void Preprocessor::use_modifier(const std::shared_ptr<VideoModifier> &modifier) {
     m_modifier = modifier;
+    build_lanes();
+}
+
+void Preprocessor::set_frames_in_flight(int frames) {
+    m_frames_in_flight = std::max(1, std::min(frames, static_cast<int>(MAX_FRAMES_IN_FLIGHT)));
+    build_lanes();
+}
+
+void Preprocessor::build_lanes() {
+    std::unique_lock<std::mutex> lock(m_lane_mutex);
+    // Lanes are only replaced once every frame in flight has been emitted
+    m_lane_free.wait(lock, [this] {
+        for (const std::unique_ptr<PreprocessorLane> &lane : m_lanes) {
+            if (lane->busy) { return false; }
+        }
+        return !m_emitting && m_reorder.size() == 0;
+    });
+    for (const std::unique_ptr<PreprocessorLane> &lane : m_lanes) {
+        m_retired_allocations += lane->pool.allocations();
+    }
+    m_lanes.clear();
+    // Frames can only be in flight together on clones of the modifier,
+    // which number them from zero
+    m_next_ticket = 0;
+    std::vector<std::shared_ptr<VideoModifier>> modifiers{m_modifier};
+    for (int i = 1; i < m_frames_in_flight; ++i) {
+        std::shared_ptr<VideoModifier> clone = m_modifier ? m_modifier->clone() : nullptr;
+        if (m_modifier && !clone) {
+            modifiers.resize(1);
+            break;
+        }
+        modifiers.push_back(clone);
+    }
+    for (const std::shared_ptr<VideoModifier> &modifier : modifiers) {
+        m_lanes.push_back(std::make_unique<PreprocessorLane>(*m_workers, modifier));
+        build_graph(*m_lanes.back());
+    }
+    m_reorder.reset(m_lanes.size(), m_next_ticket);
+    std::size_t lanes = m_lanes.size();
+    lock.unlock();
+    // A single lane runs on the preprocessor thread
+    m_frame_workers.reset();
+    if (lanes > 1) { m_frame_workers = std::make_unique<thread_pool>(lanes); }
+}
+
+void Preprocessor::build_graph(PreprocessorLane &lane) {
+    FrameGraph &graph = lane.graph;
+    graph.clear();
+    std::vector<FrameGraph::node_id> modified;
+    if (lane.modifier) {
+        FrameGraph::node_id enter = graph.add_node("modify_enter", [](FrameContext &context) {
+            context.frame.meta.enter(FrameMeta::MODIFY);
+        });
+        // The modifier may fan out into concurrent branches
+        FrameGraph::node_id modifier = lane.modifier->add_nodes(graph, {enter});
+        modified.push_back(graph.add_node("modify_exit", [](FrameContext &context) {
+            context.frame.meta.exit(FrameMeta::MODIFY);
+        }, {modifier}));
+    }
+    // Rotate and zoom frame in a single resample
+    PreprocessorLane *target = &lane;
+    graph.add_node("transform", [target](FrameContext &context) {
+        cv::Size size = context.frame.image.size();
+        target->transform.apply(context.frame.image, target->rotation_angle, target->zoom_factor, target->pool);
+        // Annotations were found on the untransformed frame
+        if (context.frame.meta.annotations) {
+            for (Annotation &annotation : *context.frame.meta.annotations) {
+                FrameTransform::map(annotation.outline, size, target->rotation_angle, target->zoom_factor);
+            }
+        }
+    }, modified);
+}
+
+void Preprocessor::dispatch(const Frame &frame) {
+    std::unique_lock<std::mutex> lock(m_lane_mutex);
+    PreprocessorLane *lane = nullptr;
+    // Wait for a free lane, and for room in the reorder buffer should
+    // an earlier frame be holding up those after it
+    m_lane_free.wait(lock, [this, &lane] {
+        if (!m_reorder.accepts(m_next_ticket)) { return false; }
+        for (const std::unique_ptr<PreprocessorLane> &candidate : m_lanes) {
+            if (!candidate->busy) {
+                lane = candidate.get();
+                return true;
+            }
+        }
+        return false;
+    });
+    lane->busy = true;
+    lane->rotation_angle = m_rotation_angle;
+    lane->zoom_factor = m_zoom_factor;
+    std::uint64_t ticket = m_next_ticket++;
+    lock.unlock();
+    m_frame_workers->post([this, lane, ticket, frame]() {
+        Frame processed = frame;
+        try {
+            PreprocessorDelegate::process(*lane, processed, ticket);
+        } catch (...) {
+            // Drop the frame rather than hold up those after it
+            processed.image.release();
+        }
+        complete(*lane, ticket, processed);
+    });
 }
 
-void Preprocessor::preprocess_frame(const cv::UMat &frame) {
-    // Queue the frame unless all frames are to be processed
-    if (m_process_all)
-    { PreprocessorDelegate::preprocess_frame_delegate(this, frame); }
-    else { queue_frame(frame); }
+void Preprocessor::complete(PreprocessorLane &lane, std::uint64_t ticket, Frame &frame) {
+    std::unique_lock<std::mutex> lock(m_lane_mutex);
+    lane.busy = false;
+    m_reorder.put(ticket, std::move(frame));
+    m_lane_free.notify_all();
+    // The thread already emitting will pick up this frame
+    if (m_emitting) { return; }
+    m_emitting = true;
+    Frame next;
+    while (m_reorder.pop(next)) {
+        lock.unlock();
+        if (!next.image.empty()) { publish(next); }
+        next.image.release();
+        lock.lock();
+    }
+    m_emitting = false;
+    m_lane_free.notify_all();
 }
 
-void Preprocessor::queue_frame(const cv::UMat &frame) {
-    // Load the frame into the single-element queue
-    s_frame = frame;
-    // If there is no current frame being processed, start the timer
-    if (!s_queue_timer.isActive()) { s_queue_timer.start(0, this); }
+void Preprocessor::publish(const Frame &frame) {
+    measure_service(frame.meta);
+    Q_EMIT frame_processed(frame);
+    if (frame.meta.detections) { Q_EMIT detections_found(*frame.meta.detections, frame.meta.capture_time); }
 }
 
-void Preprocessor::timerEvent(QTimerEvent *ev) {
-    if (ev->timerId() != s_queue_timer.timerId()) { return; }
-    // Process the frame; this function is blocking and will not
-    // return until the frame is processed, and usually has slower
-    // execution time, which limits frame rate
+void Preprocessor::measure_service(const FrameMeta &meta) {
+    std::int64_t sample = meta.exit_time[FrameMeta::PREPROCESS] - meta.enter_time[FrameMeta::PREPROCESS];
+    // Exponential moving average, seeded with the first sample
+    m_service_time = m_service_time == 0 ? sample : m_service_time + (sample - m_service_time) / SERVICE_SMOOTHING;
+    // Lanes process frames concurrently
+    Q_EMIT service_measured(m_service_time / static_cast<std::int64_t>(m_lanes.size()));
+}
 
-    // Pass copy of pointer
-    PreprocessorDelegate::preprocess_frame_delegate(this, s_frame);
-    s_frame.release();
-    // Stop the timer so that the next received frame can be processed
-    s_queue_timer.stop();
+void Preprocessor::set_queue_policy(int policy, int slots) {
+    std::shared_ptr<frame_queue> queue = std::make_shared<frame_queue>(
+        static_cast<std::size_t>(slots > 0 ? slots : 1),
+        static_cast<frame_queue::Policy>(policy)
+    );
+    std::atomic_store(&m_queue, queue);
+}
+
+void Preprocessor::set_lossless(bool lossless) {
+    m_lossless = lossless;
+    m_space.notify_all();
+}
+
+void Preprocessor::preprocess_frame(const Frame &frame) {
+    // Called on the Capture thread; push the frame into the queue
+    std::shared_ptr<frame_queue> queue = std::atomic_load(&m_queue);
+    if (!m_lossless) {
+        queue->push(frame);
+    } else {
+        // Hold up the producer until the preprocessor frees a slot
+        while (!queue->try_push(frame)) {
+            std::unique_lock<std::mutex> lock(m_space_mutex);
+            m_space.wait_for(lock, std::chrono::milliseconds(LOSSLESS_WAIT_INTERVAL));
+            if (!m_lossless) {
+                queue->push(frame);
+                break;
+            }
+            // The queue may have been replaced while waiting
+            queue = std::atomic_load(&m_queue);
+        }
+    }
+    // Wake the preprocessor thread unless it is already draining
+    if (!m_draining.exchange(true)) {
+        QMetaObject::invokeMethod(this, "process_queue", Qt::QueuedConnection);
+    }
+}
+
+void Preprocessor::process_queue() {
+    Frame frame;
+    for (;;) {
+        std::shared_ptr<frame_queue> queue = std::atomic_load(&m_queue);
+        // Processing a frame is blocking and usually slower than
+        // capture, so new frames are handled by the queue policy
+        while (queue->pop(frame)) {
+            m_space.notify_one();
+            if (m_lanes.size() > 1) {
+                dispatch(frame);
+            } else {
+                // Pass copy of pointer
+                PreprocessorDelegate::preprocess_frame_delegate(this, *m_lanes.front(), frame);
+            }
+            frame.image.release();
+        }
+        m_draining.store(false);
+        // A frame may have been pushed after the last pop but before the
+        // flag was cleared, in which case no wake up was posted for it
+        if (queue->empty() || m_draining.exchange(true)) { return; }
+    }
+}
+
+ring_buffer_stats Preprocessor::queue_stats() const {
+    return std::atomic_load(&m_queue)->stats();
+}
+
+std::size_t Preprocessor::allocations() const {
+    std::lock_guard<std::mutex> lock(m_lane_mutex);
+    std::size_t allocations = m_retired_allocations;
+    for (const std::unique_ptr<PreprocessorLane> &lane : m_lanes) {
+        allocations += lane->pool.allocations();
+    }
+    return allocations;
 }
 
 double Preprocessor::get_zoom_factor() const {
     return m_zoom_factor;
 }
+
+int Preprocessor::get_rotation_angle() const {
+    return m_rotation_angle;
+}
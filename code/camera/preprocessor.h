@@ -2,45 +2,122 @@
 #define MINOTAUR_CPP_PREPROCESSOR_H
 
 #include <QObject>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
 #include <memory>
+#include <mutex>
+#include <vector>
+
+#include "frame.h"
+#include "../utility/reorderbuffer.h"
+#include "../utility/ringbuffer.h"
 
 // Forward declarations
 namespace cv {
     class UMat;
 }
 class VideoModifier;
+class thread_pool;
+struct PreprocessorLane;
 
 /**
  * The Preprocessor is responsible for handling any modifications or
  * processes run on the raw image from the capture output before sending
  * the frame to the Converter.
  *
- * This includes VideoModifier, zoom, and rotation.
+ * This includes VideoModifier, zoom, and rotation. These stages are nodes
+ * of a FrameGraph, in which a modifier may fan out into branches that run
+ * concurrently on a pool of workers and join before the frame is drawn
+ * on and transformed. Modifiers are given a lazily built pyramid of each
+ * frame so that downsampled and grayscale images are computed at most
+ * once per frame.
+ *
+ * Frame processing is as such: a frame is received from the Capture thread
+ * and pushed into a lock-free ring buffer. The preprocessor thread is woken
+ * if it is idle and drains the buffer, processing frames in order. What
+ * happens to frames that arrive while the buffer is full depends on the
+ * queue policy; by default only the latest frame is kept. In lossless
+ * mode, used when replaying a recording as fast as possible, the producer
+ * instead waits for a free slot so that every frame is processed.
  *
- * Frame processing is as such: a frame is received from the Capture and
- * is placed in a "single-element queue". When the current frame has been
- * processed, the next frame in the queue is processed. If a frame is
- * received while the current frame is being processed, it is ignored.
+ * If the modifier can be cloned, because its results depend only on the
+ * frames, several frames are kept in flight: each is dispatched to a lane
+ * with its own clone of the modifier and processed on a pool of frame
+ * workers, and a reorder buffer emits the results in the order the frames
+ * were taken off the queue. Modifiers gated by motion share their motion
+ * gate and last results with their clones, and step through them in that
+ * order. Stateful modifiers, such as trackers, run on a single lane on the
+ * preprocessor thread.
  */
 class Preprocessor : public QObject {
 Q_OBJECT
 
 public:
+    typedef ring_buffer<Frame> frame_queue;
+
+    enum {
+        DEFAULT_QUEUE_POLICY = frame_queue::LATEST,
+        DEFAULT_QUEUE_SLOTS = 1,
+        // Workers running modifier branches alongside the preprocessor thread
+        BRANCH_WORKERS = 2,
+        // Time in milliseconds a producer waits between checks in lossless mode
+        LOSSLESS_WAIT_INTERVAL = 5,
+        // Frames processed at once by modifiers that can be cloned
+        DEFAULT_FRAMES_IN_FLIGHT = 3,
+        MAX_FRAMES_IN_FLIGHT = 8,
+        // Weight of the newest sample in the service time average is one over this
+        SERVICE_SMOOTHING = 8
+    };
+
     Preprocessor();
+    ~Preprocessor() override;
 
     /**
-     * Queue the frame to be preprocessed.
+     * Queue the frame to be preprocessed. This slot is thread-safe and
+     * should be called directly from the producer thread.
      *
      * @param frame the frame to preprocess
      */
-    Q_SLOT void preprocess_frame(const cv::UMat &frame);
+    Q_SLOT void preprocess_frame(const Frame &frame);
+
+    /**
+     * Slot invoked on the preprocessor thread to process every
+     * frame in the queue.
+     */
+    Q_SLOT void process_queue();
+
+    /**
+     * Replace the frame queue with one of the given policy and number
+     * of slots. Frames still in the old queue are discarded.
+     *
+     * @param policy one of the frame_queue policies
+     * @param slots  number of slots in the queue
+     */
+    Q_SLOT void set_queue_policy(int policy, int slots);
+
+    /**
+     * Set whether the producer should wait for a free slot rather than
+     * let the queue policy drop frames. This slot is thread-safe, and
+     * clearing it releases a producer that is waiting, so that the
+     * capture can stop.
+     *
+     * @param lossless whether no frame should be dropped
+     */
+    Q_SLOT void set_lossless(bool lossless);
+
+    /**
+     * Set the number of frames processed at once if the modifier can be
+     * cloned. Waits for the frames in flight to finish.
+     *
+     * @param frames number of frames, at most MAX_FRAMES_IN_FLIGHT
+     */
+    Q_SLOT void set_frames_in_flight(int frames);
 
     Q_SLOT void zoom_changed(double zoom_factor);
 
     Q_SLOT void rotation_changed(int angle);
 
-    Q_SLOT void convert_rgb(bool convert_rgb);
-
     /**
      * Replace the modifier in the class with the provided one.
      * This slot is fired when the modifier has been changed on the UI.
@@ -54,34 +131,149 @@ public:
      *
      * @param frame processed frame
      */
-    Q_SIGNAL void frame_processed(const cv::UMat &frame);
+    Q_SIGNAL void frame_processed(const Frame &frame);
+
+    /**
+     * Signal emitted after frame_processed() with the shapes the modifier
+     * detected in the frame, if any. Like frames, detections are emitted
+     * in the order the frames were captured.
+     *
+     * @param detections   shapes detected in the frame
+     * @param capture_time monotonic time at which the frame was captured
+     */
+    Q_SIGNAL void detections_found(const detection_list &detections, qint64 capture_time);
+
+    /**
+     * Signal emitted after each frame with the average interval at which
+     * the preprocessor can take frames, which is its service time divided
+     * by the frames it keeps in flight. Emitted from the thread that
+     * processed the frame.
+     *
+     * @param interval nanoseconds between frames
+     */
+    Q_SIGNAL void service_measured(qint64 interval);
 
     double get_zoom_factor() const;
 
+    /**
+     * @return rotation angle in degrees
+     */
+    int get_rotation_angle() const;
+
+    /**
+     * @return counts of frames enqueued, dropped, and processed
+     */
+    ring_buffer_stats queue_stats() const;
+
+    /**
+     * @return number of frame buffers allocated by the preprocessor
+     */
+    std::size_t allocations() const;
+
 private:
     // Delegate friend declaration
     friend struct PreprocessorDelegate;
 
     /**
-     * Queue a frame to be processed.
+     * Wait for the frames in flight, then rebuild the lanes for the
+     * current modifier and number of frames in flight.
+     */
+    void build_lanes();
+
+    /**
+     * Build the frame graph of a lane from its modifier.
+     *
+     * @param lane lane to build
+     */
+    void build_graph(PreprocessorLane &lane);
+
+    /**
+     * Wait for a free lane and process the frame on it on a frame worker.
+     *
+     * @param frame frame to process
+     */
+    void dispatch(const Frame &frame);
+
+    /**
+     * Release a lane that has processed a frame and emit, in order,
+     * every frame that is next in the reorder buffer.
      *
-     * @param frame
+     * @param lane   lane that processed the frame
+     * @param ticket dispatch order of the frame
+     * @param frame  processed frame, or an empty frame if it failed
      */
-    void queue_frame(const cv::UMat &frame);
+    void complete(PreprocessorLane &lane, std::uint64_t ticket, Frame &frame);
 
     /**
-     * Timer fired to trigger a frame processing.
+     * Measure and emit a processed frame and its detections. Called by
+     * one thread at a time, in frame order.
      *
-     * @param ev timer event
+     * @param frame processed frame
      */
-    void timerEvent(QTimerEvent *ev) override;
+    void publish(const Frame &frame);
+
+    /**
+     * Add a frame's service time to the average and publish the interval.
+     * Called by one thread at a time.
+     *
+     * @param meta metadata of the processed frame
+     */
+    void measure_service(const FrameMeta &meta);
 
     std::shared_ptr<VideoModifier> m_modifier;
 
+    /**
+     * Workers on which the frame graphs run concurrent branches.
+     */
+    std::unique_ptr<thread_pool> m_workers;
+    /**
+     * Each lane processes one frame at a time with its own modifier,
+     * pyramid, transform, buffers and frame graph.
+     */
+    std::vector<std::unique_ptr<PreprocessorLane>> m_lanes;
+    /**
+     * Workers processing frames in flight, when there are several lanes.
+     */
+    std::unique_ptr<thread_pool> m_frame_workers;
+    int m_frames_in_flight;
+
+    // Guards the lanes, the reorder buffer and the dispatch order
+    mutable std::mutex m_lane_mutex;
+    // Signalled when a lane is freed or a frame is emitted
+    std::condition_variable m_lane_free;
+    /**
+     * Processed frames waiting for those dispatched before them.
+     */
+    reorder_buffer<Frame> m_reorder;
+    // Dispatch order of the next frame
+    std::uint64_t m_next_ticket;
+    // Whether a thread is emitting frames from the reorder buffer
+    bool m_emitting;
+    // Buffers allocated by lanes that have been replaced
+    std::size_t m_retired_allocations;
+    // Average nanoseconds to preprocess a frame
+    std::int64_t m_service_time;
+
+    /**
+     * Frame queue between the Capture and preprocessor threads. The
+     * pointer is swapped atomically when the queue policy changes.
+     */
+    std::shared_ptr<frame_queue> m_queue;
+    /**
+     * Whether the preprocessor thread has been woken to drain the queue.
+     */
+    std::atomic<bool> m_draining;
+    /**
+     * Whether producers wait on a full queue instead of dropping.
+     */
+    std::atomic<bool> m_lossless;
+
+    // Signalled when a frame is taken off the queue
+    std::mutex m_space_mutex;
+    std::condition_variable m_space;
+
     double m_zoom_factor;
     int m_rotation_angle;
-    bool m_convert_rgb;
-    bool m_process_all;
 };
 
 #endif //MINOTAUR_CPP_PREPROCESSOR_H
@@ -1,19 +1,50 @@
 #include <opencv2/videoio/videoio_c.h>
 #include <opencv2/videoio.hpp>
 
+#include <chrono>
+#include <thread>
+
+#include "frame.h"
 #include "recorder.h"
+#include "session.h"
 #include "../utility/utility.h"
 
+static Recorder::frame_queue::Policy buffer_policy(int policy) {
+    // Blocking producers retry a rejected push until a slot frees
+    return policy == Recorder::DROP_OLDEST
+        ? Recorder::frame_queue::DROP_OLDEST
+        : Recorder::frame_queue::FIFO;
+}
+
 Recorder::Recorder(int frame_rate, bool color) :
+    m_queue(std::make_shared<frame_queue>(DEFAULT_QUEUE_SLOTS, buffer_policy(DEFAULT_QUEUE_POLICY))),
+    m_queue_policy(DEFAULT_QUEUE_POLICY),
+    m_draining(false),
     m_frame_rate(frame_rate),
     m_color(color),
-    m_recording(false) {}
+    m_recording(false),
+    m_producers(0),
+    m_recording_session(false) {}
+
+Recorder::~Recorder() = default;
 
 bool Recorder::is_recording() const {
     return m_recording;
 }
 
 void Recorder::start_recording(const QString &file, int width, int height) {
+    if (file.endsWith(session::EXTENSION)) {
+        // Sessions record frames and their metadata without loss
+        m_session_writer = std::make_unique<SessionWriter>();
+        if (!m_session_writer->open(file)) {
+            m_session_writer.reset();
+            return;
+        }
+        std::atomic_load(&m_queue)->reset_stats();
+        m_recording_session = true;
+        m_recording = true;
+        return;
+    }
     // Create the video writer
     m_video_writer = std::make_unique<cv::VideoWriter>(
         file.toStdString(),
@@ -22,21 +53,107 @@ void Recorder::start_recording(const QString &file, int width, int height) {
         cv::Size(width, height),
         m_color
     );
+    std::atomic_load(&m_queue)->reset_stats();
+    m_recording_session = false;
     m_recording = true;
 }
 
 void Recorder::stop_recording() {
+    // Stop accepting frames, then wait for the producers that got past
+    // the check before, so that no frame is queued after the last drain
+    m_recording = false;
+    m_space.notify_all();
+    while (m_producers != 0) { std::this_thread::yield(); }
+    // Encode the frames still waiting before closing the file
+    encode_queue();
     // If the video writer is active, release its resources
     if (m_video_writer) {
         if (m_video_writer->isOpened()) { m_video_writer->release(); }
-        m_video_writer.release();
+        m_video_writer.reset();
     }
-    m_recording = false;
+    if (m_session_writer) {
+        m_session_writer->close();
+        m_session_writer.reset();
+    }
+}
+
+void Recorder::frame_received(const Frame &frame) {
+    ++m_producers;
+    if (m_recording && !m_recording_session) { enqueue(frame); }
+    --m_producers;
+}
+
+void Recorder::capture_received(const Frame &frame) {
+    ++m_producers;
+    if (m_recording && m_recording_session) { enqueue(frame); }
+    --m_producers;
 }
 
-void Recorder::frame_received(const cv::UMat &img) {
-    // Write the frame if recording
-    if (m_recording && m_video_writer) {
-        m_video_writer->write(img.getMat(cv::ACCESS_READ));
+void Recorder::enqueue(const Frame &frame) {
+    std::shared_ptr<frame_queue> queue = std::atomic_load(&m_queue);
+    if (m_queue_policy == BLOCK) {
+        // Hold up the producer until the encoder frees a slot
+        while (!queue->try_push(frame)) {
+            std::unique_lock<std::mutex> lock(m_space_mutex);
+            m_space.wait_for(lock, std::chrono::milliseconds(BLOCK_WAIT_INTERVAL));
+            if (!m_recording) { return; }
+            // The queue may have been replaced while waiting
+            queue = std::atomic_load(&m_queue);
+        }
+    } else if (!queue->push(frame)) {
+        return;
     }
+    // Wake the recorder thread unless it is already draining
+    if (!m_draining.exchange(true)) {
+        QMetaObject::invokeMethod(this, "encode_queue", Qt::QueuedConnection);
+    }
+}
+
+void Recorder::encode_queue() {
+    Frame frame;
+    cv::Mat annotated;
+    for (;;) {
+        std::shared_ptr<frame_queue> queue = std::atomic_load(&m_queue);
+        while (queue->pop(frame)) {
+            m_space.notify_one();
+            frame.meta.enter(FrameMeta::RECORD);
+            if (m_session_writer) {
+                frame.meta.exit(FrameMeta::RECORD);
+                m_session_writer->write(frame.image.getMat(cv::ACCESS_READ), frame.meta);
+            } else if (m_video_writer) {
+                if (frame.meta.annotations && !frame.meta.annotations->empty()) {
+                    // The frame is shared with the display, so annotations
+                    // are drawn on a copy
+                    frame.image.copyTo(annotated);
+                    draw_annotations(annotated, *frame.meta.annotations);
+                    m_video_writer->write(annotated);
+                } else {
+                    m_video_writer->write(frame.image.getMat(cv::ACCESS_READ));
+                }
+            }
+            frame.image.release();
+        }
+        m_draining.store(false);
+        // A frame may have been pushed after the last pop but before the
+        // flag was cleared, in which case no wake up was posted for it
+        if (queue->empty() || m_draining.exchange(true)) { return; }
+    }
+}
+
+void Recorder::set_queue_policy(int policy, int slots) {
+    std::shared_ptr<frame_queue> queue = std::make_shared<frame_queue>(
+        static_cast<std::size_t>(slots > 0 ? slots : 1),
+        buffer_policy(policy)
+    );
+    m_queue_policy = policy;
+    std::atomic_store(&m_queue, queue);
+    m_space.notify_all();
+}
+
+std::size_t Recorder::queued() const {
+    return std::atomic_load(&m_queue)->size();
+}
+
+ring_buffer_stats Recorder::queue_stats() const {
+    return std::atomic_load(&m_queue)->stats();
 }
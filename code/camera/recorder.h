@@ -2,37 +2,75 @@
 #define MINOTAUR_CPP_RECORDER_H
 
 #include <QObject>
+#include <atomic>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
+
+#include "../utility/ringbuffer.h"
 
 // OpenCV forward declarations
 namespace cv {
     class UMat;
     class VideoWriter;
 }
+class SessionWriter;
+struct Frame;
 
 /**
  * This class handles a cv::VideoWriter instance that is used to
- * write preprocessed cv::Mat objects to a video file.
+ * write preprocessed cv::Mat objects to a video file, or a SessionWriter
+ * when recording to a session file. Sessions keep the captured frames,
+ * before any modification, lossless and with their metadata so that
+ * they can be replayed through the pipeline.
+ *
+ * Frames are pushed into a bounded encode queue by the producing thread
+ * and encoded on the recorder thread, so a slow encoder never holds up
+ * the pipeline and the number of frames waiting is bounded. When the
+ * queue is full, frames are dropped or the producer waits, depending on
+ * the queue policy.
  */
 class Recorder : public QObject {
 Q_OBJECT
 
 public:
+    typedef ring_buffer<Frame> frame_queue;
+
+    /**
+     * Behaviour when a frame arrives and the encode queue is full.
+     */
+    enum QueuePolicy {
+        // Reject the new frame
+        DROP_NEWEST,
+        // Evict the oldest waiting frame
+        DROP_OLDEST,
+        // Wait for the encoder to free a slot, so that no frame
+        // is lost; this holds up the producer
+        BLOCK
+    };
+
     enum {
         // Hard value for frame rate writing
-        DEFAULT_FRAME_RATE = 30
+        DEFAULT_FRAME_RATE = 30,
+        DEFAULT_QUEUE_POLICY = DROP_NEWEST,
+        // Frames waiting to be encoded before the policy applies
+        DEFAULT_QUEUE_SLOTS = 8,
+        // Time in milliseconds a blocked producer waits between checks
+        BLOCK_WAIT_INTERVAL = 5
     };
 
     explicit Recorder(
         int frame_rate = DEFAULT_FRAME_RATE,
         bool color = true
     );
+    ~Recorder() override;
 
     /**
      * Tell the recorder to start capturing video from
      * its stream, given by Qt signals.
      *
-     * @param file   the file name to save to
+     * @param file   the file name to save to; a session file is
+     *               written if it has the session extension
      * @param width  the width of the video
      * @param height the height of the video
      */
@@ -40,29 +78,96 @@ public:
 
     /**
      * Tell the recorder to stop recording video from the
-     * signal stream. The file will be closed.
+     * signal stream. Frames stop being accepted, those already
+     * queued are encoded, and the file will be closed.
      */
     Q_SLOT void stop_recording();
 
     /**
-     * Slot called with a processed frame that is written to the video
-     * file, if the recorder is active.
+     * Queue a processed frame to be written to the video file, if
+     * recording a video. This slot is thread-safe and should be
+     * called directly from the producer thread.
+     *
+     * @param frame processed frame
+     */
+    Q_SLOT void frame_received(const Frame &frame);
+
+    /**
+     * Queue a captured frame to be written to the session file, if
+     * recording a session. This slot is thread-safe and should be
+     * called directly from the producer thread.
      *
-     * @param img frame image
+     * @param frame captured frame
      */
-    Q_SLOT void frame_received(const cv::UMat &img);
+    Q_SLOT void capture_received(const Frame &frame);
+
+    /**
+     * Slot invoked on the recorder thread to encode every
+     * frame in the queue.
+     */
+    Q_SLOT void encode_queue();
+
+    /**
+     * Replace the encode queue with one of the given policy and number
+     * of slots. Frames still in the old queue are discarded.
+     *
+     * @param policy one of the queue policies
+     * @param slots  number of slots in the queue
+     */
+    Q_SLOT void set_queue_policy(int policy, int slots);
 
     bool is_recording() const;
 
+    /**
+     * @return number of frames waiting to be encoded
+     */
+    std::size_t queued() const;
+
+    /**
+     * @return counts of frames enqueued, dropped, and encoded
+     */
+    ring_buffer_stats queue_stats() const;
+
 private:
+    /**
+     * Push a frame into the encode queue according to the queue policy
+     * and wake the recorder thread.
+     *
+     * @param frame frame to encode
+     */
+    void enqueue(const Frame &frame);
+
     /**
      * Handle video writer.
      */
     std::unique_ptr<cv::VideoWriter> m_video_writer;
+    /**
+     * Handle session writer, used instead of the video writer.
+     */
+    std::unique_ptr<SessionWriter> m_session_writer;
+
+    /**
+     * Encode queue between the producer and recorder threads. The
+     * pointer is swapped atomically when the queue policy changes.
+     */
+    std::shared_ptr<frame_queue> m_queue;
+    std::atomic<int> m_queue_policy;
+    /**
+     * Whether the recorder thread has been woken to drain the queue.
+     */
+    std::atomic<bool> m_draining;
+
+    // Signalled when the encoder frees a slot for a blocked producer
+    std::mutex m_space_mutex;
+    std::condition_variable m_space;
 
     int m_frame_rate;
     bool m_color;
-    bool m_recording;
+    std::atomic<bool> m_recording;
+    // Producers that may be queueing a frame, waited for when stopping
+    std::atomic<int> m_producers;
+    // Whether the recording is a session of captured frames
+    std::atomic<bool> m_recording_session;
 };
 
 #endif //MINOTAUR_CPP_RECORDER_H
@@ -0,0 +1,161 @@
+#include <QString>
+#include <chrono>
+#include <thread>
+
+#include "replaycamera.h"
+#include "session.h"
+#include "../utility/clock_time.h"
+#include "../utility/utility.h"
+
+ReplayCamera::ReplayCamera(const cv::String &file, Pacing pacing) :
+    m_pacing(pacing),
+    m_position(-1),
+    m_start_position(-1),
+    m_start_offset(0),
+    m_start_time(0),
+    m_width(0),
+    m_height(0),
+    m_frame_rate(DEFAULT_FRAME_RATE) {
+    open(file);
+}
+
+ReplayCamera::~ReplayCamera() = default;
+
+bool ReplayCamera::open(const cv::String &filename) {
+    release();
+    m_position = -1;
+    m_start_position = -1;
+    QString file = QString::fromStdString(filename);
+    if (!file.endsWith(session::EXTENSION)) {
+        if (!cv::VideoCapture::open(filename)) { return false; }
+        double frame_rate = cv::VideoCapture::get(cv::CAP_PROP_FPS);
+        m_frame_rate = frame_rate > 0 ? frame_rate : DEFAULT_FRAME_RATE;
+        return true;
+    }
+    m_session = std::make_unique<SessionReader>();
+    if (!m_session->open(file)) {
+        m_session.reset();
+        return false;
+    }
+    // Frame size and average rate of the session
+    cv::Mat image;
+    FrameMeta first;
+    FrameMeta last;
+    if (m_session->read(0, image, first)) {
+        m_width = image.cols;
+        m_height = image.rows;
+    }
+    if (m_session->size() > 1 && m_session->read_meta(m_session->size() - 1, last)) {
+        double duration = (last.capture_time - first.capture_time) * 1e-9;
+        if (duration > 0) { m_frame_rate = (m_session->size() - 1) / duration; }
+    }
+    return true;
+}
+
+bool ReplayCamera::open(const cv::String &filename, int) {
+    return open(filename);
+}
+
+bool ReplayCamera::open(int) {
+    return false;
+}
+
+bool ReplayCamera::isOpened() const {
+    return m_session ? m_session->is_open() : cv::VideoCapture::isOpened();
+}
+
+void ReplayCamera::release() {
+    if (m_session) {
+        m_session->close();
+        m_session.reset();
+    }
+    cv::VideoCapture::release();
+}
+
+bool ReplayCamera::grab() {
+    if (m_session) {
+        if (m_position + 1 >= static_cast<std::int64_t>(m_session->size())) { return false; }
+    } else if (!cv::VideoCapture::grab()) {
+        return false;
+    }
+    ++m_position;
+    if (m_pacing != REAL_TIME) { return true; }
+    std::int64_t offset = frame_offset();
+    if (m_start_position < 0) {
+        // Pace the following frames from this one
+        m_start_position = m_position;
+        m_start_offset = offset;
+        m_start_time = ClockTime::monotonic_ns();
+    } else {
+        // Block until the frame is due, as a live camera would
+        std::int64_t wait = m_start_time + (offset - m_start_offset) - ClockTime::monotonic_ns();
+        if (wait > 0) { std::this_thread::sleep_for(std::chrono::nanoseconds(wait)); }
+    }
+    return true;
+}
+
+bool ReplayCamera::retrieve(cv::OutputArray image, int flag) {
+    if (!m_session) { return cv::VideoCapture::retrieve(image, flag); }
+    cv::Mat frame;
+    FrameMeta meta;
+    if (m_position < 0 || !m_session->read(static_cast<std::size_t>(m_position), frame, meta)) { return false; }
+    // Copy out of the mapping into the caller's buffer
+    frame.copyTo(image);
+    return true;
+}
+
+bool ReplayCamera::read(cv::OutputArray image) {
+    return grab() && retrieve(image, 0);
+}
+
+bool ReplayCamera::set(int prop_id, double value) {
+    if (prop_id != cv::CAP_PROP_POS_FRAMES) {
+        return !m_session && cv::VideoCapture::set(prop_id, value);
+    }
+    std::int64_t frame = static_cast<std::int64_t>(value);
+    if (frame < 0) { return false; }
+    if (m_session) {
+        if (frame > static_cast<std::int64_t>(m_session->size())) { return false; }
+    } else if (!cv::VideoCapture::set(prop_id, value)) {
+        return false;
+    }
+    // The next grab returns the requested frame
+    m_position = frame - 1;
+    m_start_position = -1;
+    return true;
+}
+
+double ReplayCamera::get(int prop_id) const {
+    switch (prop_id) {
+        case cv::CAP_PROP_POS_FRAMES:
+            return static_cast<double>(m_position + 1);
+        case cv::CAP_PROP_FPS:
+            return m_frame_rate;
+        default:
+            break;
+    }
+    if (!m_session) { return cv::VideoCapture::get(prop_id); }
+    switch (prop_id) {
+        case cv::CAP_PROP_FRAME_WIDTH:
+            return m_width;
+        case cv::CAP_PROP_FRAME_HEIGHT:
+            return m_height;
+        case cv::CAP_PROP_FRAME_COUNT:
+            return static_cast<double>(m_session->size());
+        default:
+            return 0;
+    }
+}
+
+ReplayCamera::Pacing ReplayCamera::pacing() const {
+    return m_pacing;
+}
+
+std::int64_t ReplayCamera::frame_offset() const {
+    FrameMeta meta;
+    if (m_session && m_session->read_meta(static_cast<std::size_t>(m_position), meta)) {
+        return meta.capture_time;
+    }
+    // Videos are paced at their nominal frame rate
+    return static_cast<std::int64_t>(m_position * 1e9 / m_frame_rate);
+}
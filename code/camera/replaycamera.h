@@ -0,0 +1,89 @@
+#ifndef MINOTAUR_CPP_REPLAYCAMERA_H
+#define MINOTAUR_CPP_REPLAYCAMERA_H
+
+#include <opencv2/videoio.hpp>
+
+#include <cstdint>
+#include <memory>
+
+class SessionReader;
+
+/**
+ * VideoCapture that plays back a recorded session or a video file, so
+ * that the pipeline can be run on footage from real runs. It is read by
+ * the Capture grab thread like a live camera.
+ *
+ * In real-time mode each grab blocks until the frame's original capture
+ * time, relative to the first frame. In as-fast-as-possible mode grabs
+ * return immediately; the Capture then holds up on a full preprocessor
+ * queue instead of dropping, so every frame is processed in order.
+ */
+class ReplayCamera : public cv::VideoCapture {
+public:
+    enum {
+        REPLAY_CAMERA = -2,
+        // Frame rate assumed for videos that do not report one
+        DEFAULT_FRAME_RATE = 30
+    };
+
+    enum Pacing {
+        REAL_TIME,
+        AS_FAST_AS_POSSIBLE
+    };
+
+    /**
+     * Open a session file, identified by its extension, or a video file.
+     *
+     * @param file   path of the recording
+     * @param pacing playback pacing
+     */
+    ReplayCamera(const cv::String &file, Pacing pacing);
+    ~ReplayCamera() override;
+
+    bool open(const cv::String &filename) override;
+    bool open(const cv::String &filename, int api_pref) override;
+    bool open(int index) override;
+
+    bool isOpened() const override;
+    void release() override;
+
+    /**
+     * Advance to the next frame, waiting for its time in real-time mode.
+     *
+     * @return false at the end of the recording
+     */
+    bool grab() override;
+    bool retrieve(cv::OutputArray image, int flag) override;
+
+    bool read(cv::OutputArray image) override;
+
+    /**
+     * Supports seeking with CAP_PROP_POS_FRAMES, in constant
+     * time for sessions. Pacing restarts from the new frame.
+     */
+    bool set(int prop_id, double value) override;
+    double get(int prop_id) const override;
+
+    Pacing pacing() const;
+
+private:
+    /**
+     * @return time of the grabbed frame in the recording, in nanoseconds
+     */
+    std::int64_t frame_offset() const;
+
+    std::unique_ptr<SessionReader> m_session;
+    Pacing m_pacing;
+    // Index of the grabbed frame, or -1 before the first grab
+    std::int64_t m_position;
+    // Frame from which pacing started and when it was played
+    std::int64_t m_start_position;
+    std::int64_t m_start_offset;
+    std::int64_t m_start_time;
+    // Session frame size and rate, read when the session is opened
+    int m_width;
+    int m_height;
+    double m_frame_rate;
+};
+
+#endif //MINOTAUR_CPP_REPLAYCAMERA_H
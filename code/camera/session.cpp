@@ -0,0 +1,277 @@
+#include <opencv2/imgcodecs.hpp>
+
+#include <QFile>
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
+#include "session.h"
+#include "../utility/utility.h"
+
+const char *const session::EXTENSION = ".session";
+
+enum {
+    FORMAT_VERSION = 1,
+    // Records start on multiples of this many bytes
+    RECORD_ALIGNMENT = 64,
+    // Marks the start of each record
+    RECORD_MAGIC = 0x4d415246
+};
+
+static const char FILE_MAGIC[8] = {'M', 'I', 'N', 'O', 'S', 'E', 'S', 'S'};
+static const char INDEX_MAGIC[8] = {'M', 'I', 'N', 'O', 'I', 'D', 'X', '1'};
+
+struct file_header {
+    char magic[8];
+    std::uint32_t version;
+    // Number of stages in the stored FrameMeta times
+    std::uint32_t stages;
+};
+
+struct record_header {
+    std::uint32_t magic;
+    std::uint32_t compression;
+    std::int32_t rows;
+    std::int32_t cols;
+    std::int32_t type;
+    std::uint32_t reserved;
+    std::uint64_t payload_size;
+    std::uint64_t sequence;
+    std::int64_t capture_time;
+    std::int64_t enter_time[FrameMeta::NUM_STAGES];
+    std::int64_t exit_time[FrameMeta::NUM_STAGES];
+};
+
+struct file_footer {
+    std::uint64_t index_offset;
+    std::uint64_t frame_count;
+    char magic[8];
+};
+
+static_assert(std::is_trivially_copyable<record_header>::value, "record header must be trivially copyable");
+
+static std::uint64_t align(std::uint64_t offset) {
+    return (offset + RECORD_ALIGNMENT - 1) / RECORD_ALIGNMENT * RECORD_ALIGNMENT;
+}
+
+/**
+ * Copy the header of a mapped record and check that the whole
+ * record lies within the file.
+ *
+ * @return a pointer to the pixels following the header, or nullptr
+ */
+static const uchar *find_record(const uchar *data, std::uint64_t size, std::uint64_t offset, record_header &header) {
+    if (offset + sizeof(header) > size) { return nullptr; }
+    std::memcpy(&header, data + offset, sizeof(header));
+    if (header.magic != RECORD_MAGIC || header.payload_size > size - offset - sizeof(header)) { return nullptr; }
+    return data + offset + sizeof(header);
+}
+
+static void copy_meta(const record_header &header, FrameMeta &meta) {
+    meta.sequence = header.sequence;
+    meta.capture_time = header.capture_time;
+    std::copy(header.enter_time, header.enter_time + FrameMeta::NUM_STAGES, meta.enter_time);
+    std::copy(header.exit_time, header.exit_time + FrameMeta::NUM_STAGES, meta.exit_time);
+}
+
+SessionWriter::SessionWriter(session::Compression compression) :
+    m_compression(compression) {}
+
+SessionWriter::~SessionWriter() {
+    close();
+}
+
+bool SessionWriter::open(const QString &file) {
+    close();
+    m_file = std::make_unique<QFile>(file);
+    if (!m_file->open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        m_file.reset();
+        return false;
+    }
+    file_header header{};
+    std::memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+    header.version = FORMAT_VERSION;
+    header.stages = FrameMeta::NUM_STAGES;
+    if (m_file->write(reinterpret_cast<const char *>(&header), sizeof(header)) != sizeof(header) || !pad()) {
+        m_file.reset();
+        return false;
+    }
+    return true;
+}
+
+bool SessionWriter::write(const cv::Mat &image, const FrameMeta &meta) {
+    if (!m_file) { return false; }
+    record_header header{};
+    header.magic = RECORD_MAGIC;
+    header.compression = m_compression;
+    header.rows = image.rows;
+    header.cols = image.cols;
+    header.type = image.type();
+    header.sequence = meta.sequence;
+    header.capture_time = meta.capture_time;
+    std::copy(meta.enter_time, meta.enter_time + FrameMeta::NUM_STAGES, header.enter_time);
+    std::copy(meta.exit_time, meta.exit_time + FrameMeta::NUM_STAGES, header.exit_time);
+
+    const char *payload;
+    cv::Mat continuous;
+    if (m_compression == session::PNG) {
+        cv::imencode(".png", image, m_encoded, {cv::IMWRITE_PNG_COMPRESSION, 1});
+        payload = reinterpret_cast<const char *>(m_encoded.data());
+        header.payload_size = m_encoded.size();
+    } else {
+        // Rows of a submatrix are not contiguous
+        continuous = image.isContinuous() ? image : image.clone();
+        payload = reinterpret_cast<const char *>(continuous.data);
+        header.payload_size = continuous.total() * continuous.elemSize();
+    }
+
+    std::uint64_t offset = static_cast<std::uint64_t>(m_file->pos());
+    qint64 payload_size = static_cast<qint64>(header.payload_size);
+    if (
+        m_file->write(reinterpret_cast<const char *>(&header), sizeof(header)) != sizeof(header) ||
+        m_file->write(payload, payload_size) != payload_size ||
+        !pad()
+    ) {
+        return false;
+    }
+    m_index.push_back(offset);
+    return true;
+}
+
+void SessionWriter::close() {
+    if (!m_file) { return; }
+    file_footer footer{};
+    footer.index_offset = static_cast<std::uint64_t>(m_file->pos());
+    footer.frame_count = m_index.size();
+    std::memcpy(footer.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    m_file->write(reinterpret_cast<const char *>(m_index.data()),
+                  static_cast<qint64>(m_index.size() * sizeof(std::uint64_t)));
+    m_file->write(reinterpret_cast<const char *>(&footer), sizeof(footer));
+    m_file->close();
+    m_file.reset();
+    m_index.clear();
+}
+
+bool SessionWriter::is_open() const {
+    return m_file != nullptr;
+}
+
+std::size_t SessionWriter::size() const {
+    return m_index.size();
+}
+
+bool SessionWriter::pad() {
+    static const char zeros[RECORD_ALIGNMENT] = {};
+    qint64 pos = m_file->pos();
+    qint64 padding = static_cast<qint64>(align(static_cast<std::uint64_t>(pos))) - pos;
+    return padding == 0 || m_file->write(zeros, padding) == padding;
+}
+
+SessionReader::SessionReader() :
+    m_data(nullptr),
+    m_size(0) {}
+
+SessionReader::~SessionReader() {
+    close();
+}
+
+bool SessionReader::open(const QString &file) {
+    close();
+    m_file = std::make_unique<QFile>(file);
+    if (!m_file->open(QIODevice::ReadOnly) || m_file->size() < static_cast<qint64>(sizeof(file_header))) {
+        close();
+        return false;
+    }
+    m_size = static_cast<std::uint64_t>(m_file->size());
+    m_data = m_file->map(0, m_file->size());
+    if (!m_data) {
+        close();
+        return false;
+    }
+    file_header header;
+    std::memcpy(&header, m_data, sizeof(header));
+    if (
+        std::memcmp(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0 ||
+        header.version != FORMAT_VERSION ||
+        header.stages != FrameMeta::NUM_STAGES
+    ) {
+        close();
+        return false;
+    }
+    // Use the footer index if the session was closed
+    file_footer footer{};
+    if (m_size >= align(sizeof(file_header)) + sizeof(footer)) {
+        std::memcpy(&footer, m_data + m_size - sizeof(footer), sizeof(footer));
+    }
+    std::uint64_t index_size = footer.frame_count * sizeof(std::uint64_t);
+    if (
+        std::memcmp(footer.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) == 0 &&
+        footer.frame_count <= m_size / sizeof(std::uint64_t) &&
+        footer.index_offset <= m_size &&
+        footer.index_offset + index_size + sizeof(footer) == m_size
+    ) {
+        m_index.resize(footer.frame_count);
+        std::memcpy(m_index.data(), m_data + footer.index_offset, index_size);
+    } else {
+        scan();
+    }
+    return true;
+}
+
+void SessionReader::close() {
+    if (m_file) {
+        if (m_data) { m_file->unmap(const_cast<uchar *>(m_data)); }
+        m_file->close();
+        m_file.reset();
+    }
+    m_data = nullptr;
+    m_size = 0;
+    m_index.clear();
+}
+
+bool SessionReader::is_open() const {
+    return m_data != nullptr;
+}
+
+std::size_t SessionReader::size() const {
+    return m_index.size();
+}
+
+bool SessionReader::read(std::size_t index, cv::Mat &image, FrameMeta &meta) const {
+    if (index >= m_index.size()) { return false; }
+    record_header header;
+    const uchar *pixels = find_record(m_data, m_size, m_index[index], header);
+    if (!pixels) { return false; }
+    copy_meta(header, meta);
+
+    uchar *payload = const_cast<uchar *>(pixels);
+    if (header.compression == session::PNG) {
+        cv::Mat encoded(1, static_cast<int>(header.payload_size), CV_8U, payload);
+        image = cv::imdecode(encoded, cv::IMREAD_UNCHANGED);
+        return !image.empty();
+    }
+    cv::Mat raw(header.rows, header.cols, header.type, payload);
+    if (raw.total() * raw.elemSize() != header.payload_size) { return false; }
+    image = raw;
+    return true;
+}
+
+bool SessionReader::read_meta(std::size_t index, FrameMeta &meta) const {
+    if (index >= m_index.size()) { return false; }
+    record_header header;
+    if (!find_record(m_data, m_size, m_index[index], header)) { return false; }
+    copy_meta(header, meta);
+    return true;
+}
+
+void SessionReader::scan() {
+    m_index.clear();
+    std::uint64_t offset = align(sizeof(file_header));
+    record_header header;
+    // Stop at the first incomplete record, which an interrupted
+    // recording may have left at the end of the file
+    while (find_record(m_data, m_size, offset, header)) {
+        m_index.push_back(offset);
+        offset = align(offset + sizeof(header) + header.payload_size);
+    }
+}
@@ -0,0 +1,153 @@
+#ifndef MINOTAUR_CPP_SESSION_H
+#define MINOTAUR_CPP_SESSION_H
+
+#include <opencv2/core/core.hpp>
+
+#include <QString>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "frame.h"
+
+class QFile;
+
+/**
+ * Session files store a run's frames with their metadata so that it can
+ * be replayed exactly. The file is a header, then one record per frame,
+ * each a fixed-size header holding the image geometry and FrameMeta
+ * followed by the raw or PNG-compressed pixels, and finally a footer index
+ * of record offsets. Records are aligned so raw pixels can be used in
+ * place from a memory mapping. Values are stored in host byte order.
+ */
+namespace session {
+    /**
+     * File name extension of session files.
+     */
+    extern const char *const EXTENSION;
+
+    enum Compression {
+        // Pixels are stored as is
+        RAW,
+        // Lossless PNG at the fastest compression level
+        PNG
+    };
+}
+
+/**
+ * Writes frames to a session file by appending. The index is written when
+ * the session is closed; a session that was not closed is still readable
+ * by scanning its records.
+ */
+class SessionWriter {
+public:
+    explicit SessionWriter(session::Compression compression = session::RAW);
+    ~SessionWriter();
+
+    /**
+     * Create or truncate a session file and write its header.
+     *
+     * @param file path of the session file
+     * @return whether the file was opened
+     */
+    bool open(const QString &file);
+
+    /**
+     * Append a frame to the session.
+     *
+     * @param image frame image
+     * @param meta  frame metadata
+     * @return whether the frame was written
+     */
+    bool write(const cv::Mat &image, const FrameMeta &meta);
+
+    /**
+     * Write the footer index and close the file.
+     */
+    void close();
+
+    bool is_open() const;
+
+    /**
+     * @return number of frames written
+     */
+    std::size_t size() const;
+
+private:
+    /**
+     * Write zeros up to the next record boundary.
+     */
+    bool pad();
+
+    std::unique_ptr<QFile> m_file;
+    // Offsets of the written records
+    std::vector<std::uint64_t> m_index;
+    // Scratch buffer for compressed frames
+    std::vector<uchar> m_encoded;
+    session::Compression m_compression;
+};
+
+/**
+ * Reads a session file through a memory mapping. Any frame can be read
+ * in constant time, and raw frames are not copied.
+ */
+class SessionReader {
+public:
+    SessionReader();
+    ~SessionReader();
+
+    /**
+     * Map a session file and load its index. If the file has no index,
+     * because it was not closed, the records are scanned instead.
+     *
+     * @param file path of the session file
+     * @return whether the file is a readable session
+     */
+    bool open(const QString &file);
+
+    /**
+     * Unmap and close the file. Images read from raw frames are no
+     * longer valid.
+     */
+    void close();
+
+    bool is_open() const;
+
+    /**
+     * @return number of frames in the session
+     */
+    std::size_t size() const;
+
+    /**
+     * Read a frame. A raw frame refers to read-only mapped memory, valid
+     * until the reader is closed, and must not be written to.
+     *
+     * @param index frame index
+     * @param image frame image
+     * @param meta  frame metadata
+     * @return whether the frame was read
+     */
+    bool read(std::size_t index, cv::Mat &image, FrameMeta &meta) const;
+
+    /**
+     * Read the metadata of a frame without its image.
+     *
+     * @param index frame index
+     * @param meta  frame metadata
+     * @return whether the frame exists
+     */
+    bool read_meta(std::size_t index, FrameMeta &meta) const;
+
+private:
+    /**
+     * Rebuild the index by walking the records from the first one.
+     */
+    void scan();
+
+    std::unique_ptr<QFile> m_file;
+    const uchar *m_data;
+    std::uint64_t m_size;
+    std::vector<std::uint64_t> m_index;
+};
+
+#endif //MINOTAUR_CPP_SESSION_H
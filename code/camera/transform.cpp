@@ -0,0 +1,68 @@
+#include <opencv2/imgproc.hpp>
+#include <cmath>
+
+#include "framepool.h"
+#include "transform.h"
+
+FrameTransform::FrameTransform() :
+    m_angle(0.0),
+    m_zoom(1.0) {}
+
+bool FrameTransform::is_identity(double angle, double zoom) {
+    return std::fmod(angle, 360.0) == 0.0 && zoom == 1.0;
+}
+
+void FrameTransform::map(std::vector<cv::Point> &points, const cv::Size &size, double angle, double zoom) {
+    if (is_identity(angle, zoom)) { return; }
+    cv::Point2f center(size.width * 0.5f, size.height * 0.5f);
+    cv::Mat forward = cv::getRotationMatrix2D(center, angle, zoom);
+    const double *m = forward.ptr<double>();
+    for (cv::Point &p : points) {
+        p = cv::Point(cvRound(m[0] * p.x + m[1] * p.y + m[2]), cvRound(m[3] * p.x + m[4] * p.y + m[5]));
+    }
+}
+
+cv::Point2d FrameTransform::unmap(const cv::Point2d &point, const cv::Size &size, double angle, double zoom) {
+    if (is_identity(angle, zoom)) { return point; }
+    cv::Point2f center(size.width * 0.5f, size.height * 0.5f);
+    cv::Mat inverse;
+    cv::invertAffineTransform(cv::getRotationMatrix2D(center, angle, zoom), inverse);
+    const double *m = inverse.ptr<double>();
+    return cv::Point2d(m[0] * point.x + m[1] * point.y + m[2], m[3] * point.x + m[4] * point.y + m[5]);
+}
+
+void FrameTransform::apply(cv::UMat &frame, double angle, double zoom, FramePool &pool) {
+    if (is_identity(angle, zoom) || frame.empty()) { return; }
+    if (frame.size() != m_size || angle != m_angle || zoom != m_zoom || m_map_xy.empty()) {
+        rebuild(frame.size(), angle, zoom);
+    }
+    // Single resample through the cached tables
+    cv::UMat dst = pool.acquire(frame.size(), frame.type());
+    cv::remap(frame, dst, m_map_xy, m_map_frac, cv::INTER_LINEAR);
+    frame = dst;
+}
+
+void FrameTransform::rebuild(const cv::Size &size, double angle, double zoom) {
+    // Rotation about the center followed by a zoom about the center
+    cv::Point2f center(size.width * 0.5f, size.height * 0.5f);
+    cv::Mat forward = cv::getRotationMatrix2D(center, angle, zoom);
+    // Remap needs the source location of each destination pixel
+    cv::Mat inverse;
+    cv::invertAffineTransform(forward, inverse);
+    const double *m = inverse.ptr<double>();
+    cv::Mat map_x(size, CV_32FC1);
+    cv::Mat map_y(size, CV_32FC1);
+    for (int y = 0; y < size.height; ++y) {
+        float *row_x = map_x.ptr<float>(y);
+        float *row_y = map_y.ptr<float>(y);
+        for (int x = 0; x < size.width; ++x) {
+            row_x[x] = static_cast<float>(m[0] * x + m[1] * y + m[2]);
+            row_y[x] = static_cast<float>(m[3] * x + m[4] * y + m[5]);
+        }
+    }
+    // Fixed-point tables are faster to remap with
+    cv::convertMaps(map_x, map_y, m_map_xy, m_map_frac, CV_16SC2);
+    m_size = size;
+    m_angle = angle;
+    m_zoom = zoom;
+}
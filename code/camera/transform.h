@@ -0,0 +1,84 @@
+#ifndef MINOTAUR_CPP_TRANSFORM_H
+#define MINOTAUR_CPP_TRANSFORM_H
+
+#include <opencv2/core/core.hpp>
+#include <vector>
+
+class FramePool;
+
+/**
+ * Rotation and zoom of a frame about its center, fused into a single
+ * affine resample.
+ *
+ * Rotating by an angle and then cropping and scaling the center of the
+ * frame by a zoom factor is the same affine transform as a rotation about
+ * the center with a scale equal to the zoom. The remap tables for that
+ * transform are cached and only rebuilt when the angle, zoom, or frame
+ * size changes, and the identity transform does no work at all.
+ */
+class FrameTransform {
+public:
+    FrameTransform();
+
+    /**
+     * Rotate and zoom the frame into a pooled buffer of the same size.
+     * The frame is left untouched for the identity transform.
+     *
+     * @param frame frame to transform, replaced by the result
+     * @param angle rotation angle in degrees
+     * @param zoom  zoom factor, where 1.0 is no zoom
+     * @param pool  pool from which to acquire the output buffer
+     */
+    void apply(cv::UMat &frame, double angle, double zoom, FramePool &pool);
+
+    /**
+     * @param angle rotation angle in degrees
+     * @param zoom  zoom factor
+     * @return whether the transform leaves frames unchanged
+     */
+    static bool is_identity(double angle, double zoom);
+
+    /**
+     * Move points of a frame to where the transform puts them, so that
+     * annotations follow the frame they were found on.
+     *
+     * @param points points in frame pixels, replaced by the result
+     * @param size   frame size
+     * @param angle  rotation angle in degrees
+     * @param zoom   zoom factor
+     */
+    static void map(std::vector<cv::Point> &points, const cv::Size &size, double angle, double zoom);
+
+    /**
+     * Move a point of a transformed frame back to where it was before
+     * the transform, such as a point selected on the display.
+     *
+     * @param point point in transformed frame pixels
+     * @param size  frame size
+     * @param angle rotation angle in degrees
+     * @param zoom  zoom factor
+     * @return the point in frame pixels
+     */
+    static cv::Point2d unmap(const cv::Point2d &point, const cv::Size &size, double angle, double zoom);
+
+private:
+    /**
+     * Rebuild the cached remap tables.
+     *
+     * @param size  frame size
+     * @param angle rotation angle in degrees
+     * @param zoom  zoom factor
+     */
+    void rebuild(const cv::Size &size, double angle, double zoom);
+
+    // Fixed-point remap tables
+    cv::Mat m_map_xy;
+    cv::Mat m_map_frac;
+
+    // Parameters of the cached tables
+    cv::Size m_size;
+    double m_angle;
+    double m_zoom;
+};
+
+#endif //MINOTAUR_CPP_TRANSFORM_H
@@ -1,14 +1,17 @@
 #include "compstate.h"
 #include "objectprocedure.h"
 #include "parammanager.h"
+#include "posefilter.h"
 #include "procedure.h"
 
 #include "../camera/statusbox.h"
 #include "../camera/statuslabel.h"
 #include "../gui/global.h"
+#include "../utility/clock_time.h"
 #include "../utility/logger.h"
 #include "../utility/utility.h"
 #include "../utility/vector.h"
+#include "../video/detection.h"
 
 #include <opencv2/core/types.hpp>
 
@@ -49,15 +52,34 @@ struct CompetitionState::Impl {
     cv::Rect2d box_robot;
     cv::Rect2d box_object;
     cv::Rect2d box_target;
+
+    PoseFilter pose_robot;
+    PoseFilter pose_object;
 };
 
+/**
+ * Fuse a tracked box into a pose filter.
+ *
+ * @param filter filter of the tracked entity
+ * @param box    tracked box
+ * @param time   capture time of the frame the box was tracked on
+ * @return the filtered velocity
+ */
+static cv::Point2d filter_box(PoseFilter &filter, const cv::Rect2d &box, std::int64_t time) {
+    filter.set_noise(g_pm->pose_process_noise, g_pm->pose_measure_noise);
+    filter.measure(box, time);
+    return filter.estimate(time).velocity;
+}
+
 CompetitionState::CompetitionState(MainWindow *parent) :
     m_parent(parent),
     m_impl(std::make_unique<Impl>()),
     m_tracking_robot(false),
     m_tracking_object(false),
     m_acquire_walls(false),
-    m_object_type(UNACQUIRED) {
+    m_object_type(UNACQUIRED),
+    m_roi_request(NO_ROI),
+    m_path_revision(0) {
     if (auto lp = parent->status_box().lock()) {
         m_robot_loc_label = lp->add_label(center_text(cv::Rect2d(), "Robot"));
         m_object_loc_label = lp->add_label(center_text(cv::Rect2d(), "Object"));
@@ -66,28 +88,77 @@ CompetitionState::CompetitionState(MainWindow *parent) :
 
 CompetitionState::~CompetitionState() = default;
 
-void CompetitionState::acquire_robot_box(const cv::Rect2d &robot_box) {
+void CompetitionState::acquire_robot_box(const cv::Rect2d &robot_box, qint64 capture_time) {
 #ifndef NDEBUG
     assert(m_robot_loc_label != nullptr);
 #endif
     m_robot_loc_label->setText(center_text(robot_box, "Robot"));
     m_impl->box_robot = robot_box;
     m_robot_box_fresh = true;
+    cv::Point2d velocity = filter_box(m_impl->pose_robot, robot_box, capture_time);
+    Q_EMIT robot_velocity(velocity.x, velocity.y);
 }
 
-void CompetitionState::acquire_object_box(const cv::Rect2d &object_box) {
+void CompetitionState::acquire_object_box(const cv::Rect2d &object_box, qint64 capture_time) {
 #ifndef NDEBUG
     assert(m_object_loc_label != nullptr);
 #endif
     m_object_loc_label->setText(center_text(object_box, "Object"));
     m_impl->box_object = object_box;
     m_object_box_fresh = true;
+    cv::Point2d velocity = filter_box(m_impl->pose_object, object_box, capture_time);
+    Q_EMIT object_velocity(velocity.x, velocity.y);
+}
+
+void CompetitionState::command_robot(int dx, int dy, int step_time) {
+    if (g_pm->pose_command_speed <= 0) { return; }
+    std::int64_t now = ClockTime::monotonic_ns();
+    cv::Point2d velocity = cv::Point2d(dx, dy) * g_pm->pose_command_speed;
+    m_impl->pose_robot.command(velocity, now, now + static_cast<std::int64_t>(step_time) * 1000000);
 }
 
 void CompetitionState::acquire_target_box(const cv::Rect2d &target_box) {
     m_impl->box_target = target_box;
 }
 
+void CompetitionState::acquire_detections(const std::vector<Detection> &detections, qint64 capture_time) {
+    if (m_tracking_object) { return; }
+    const Detection *best = nullptr;
+    for (const Detection &detection : detections) {
+        if (m_object_type != UNACQUIRED && detection.type != m_object_type) { continue; }
+        if (!best || detection.confidence > best->confidence) { best = &detection; }
+    }
+    if (!best || best->confidence < g_pm->shape_min_confidence) { return; }
+    if (m_object_type == UNACQUIRED) { set_object_type(best->type); }
+    acquire_object_box(best->box, capture_time);
+    Q_EMIT object_detected(best->box);
+}
+
+void CompetitionState::request_roi(int request) {
+    m_roi_request = request;
+    if (request == ROBOT_ROI) {
+        log() << "Drag a box around the robot";
+        Q_EMIT request_robot_box();
+    } else if (request == OBJECT_ROI) {
+        log() << "Drag a box around the object";
+        Q_EMIT request_object_box();
+    }
+}
+
+void CompetitionState::select_roi(const cv::Rect2d &roi) {
+    int request = m_roi_request;
+    m_roi_request = NO_ROI;
+    if (request == ROBOT_ROI) {
+        Q_EMIT robot_roi_selected(roi);
+    } else if (request == OBJECT_ROI) {
+        Q_EMIT object_roi_selected(roi);
+    }
+}
+
+int CompetitionState::roi_request() const {
+    return m_roi_request;
+}
+
 void CompetitionState::acquire_walls(std::shared_ptr<wall_arr> &walls) {
     m_walls = walls;
 }
@@ -105,11 +176,18 @@ int CompetitionState::object_type() const {
 }
 
 void CompetitionState::set_tracking_robot(bool tracking_robot) {
+    // A stopped tracker no longer waits for its region of interest
+    if (!tracking_robot && m_roi_request == ROBOT_ROI) { m_roi_request = NO_ROI; }
+    if (!tracking_robot) { m_impl->pose_robot.reset(); }
     m_tracking_robot = tracking_robot;
 }
 
 void CompetitionState::set_tracking_object(bool tracking_object) {
+    if (!tracking_object && m_roi_request == OBJECT_ROI) { m_roi_request = NO_ROI; }
+    if (!tracking_object) { m_impl->pose_object.reset(); }
+    if (m_tracking_object == tracking_object) { return; }
     m_tracking_object = tracking_object;
+    Q_EMIT object_locked(tracking_object);
 }
 
 void CompetitionState::set_object_type(int object_type) {
@@ -146,8 +224,22 @@ bool CompetitionState::is_object_box_valid() const {
     return acquisition_r(m_impl->box_object, g_pm->object_calib_area) < g_pm->area_acq_r_sigma;
 }
 
+PoseEstimate CompetitionState::robot_pose() const {
+    return m_impl->pose_robot.estimate(ClockTime::monotonic_ns());
+}
+
+PoseEstimate CompetitionState::object_pose() const {
+    return m_impl->pose_object.estimate(ClockTime::monotonic_ns());
+}
+
+bool CompetitionState::is_pose_current(const PoseEstimate &pose) const {
+    std::int64_t max_age = static_cast<std::int64_t>(g_pm->pose_max_age) * 1000000;
+    return pose.valid && pose.time - pose.measured_time <= max_age;
+}
+
 void CompetitionState::clear_path() {
     m_path.clear();
+    ++m_path_revision;
 }
 
 void CompetitionState::append_path(double x, double y) {
@@ -155,12 +247,17 @@ void CompetitionState::append_path(double x, double y) {
     qDebug() << '(' << x << ',' << ' ' << y << ')';
 #endif
     m_path.emplace_back(x, y);
+    ++m_path_revision;
 }
 
 const path2d &CompetitionState::get_path() const {
     return m_path;
 }
 
+std::uint64_t CompetitionState::path_revision() const {
+    return m_path_revision;
+}
+
 void CompetitionState::begin_traversal() {
     m_procedure = std::make_unique<Procedure>(Main::get()->controller(), m_path);
     m_procedure->start();
@@ -2,6 +2,7 @@
 #define MINOTAUR_CPP_COMPSTATE_H
 
 #include <QObject>
+#include <cstdint>
 #include <vector>
 #include <memory>
 
@@ -18,6 +19,8 @@ class MainWindow;
 class StatusLabel;
 class Procedure;
 class ObjectProcedure;
+struct Detection;
+struct PoseEstimate;
 typedef std::vector<nrg::vector<double>> path2d;
 
 /**
@@ -41,6 +44,15 @@ public:
         UNACQUIRED
     };
 
+    /**
+     * Tracker waiting for a region of interest to be selected.
+     */
+    enum RoiRequest {
+        ROBOT_ROI,
+        OBJECT_ROI,
+        NO_ROI
+    };
+
     enum {
         wall_is_bool = std::is_same<wall_t, bool>::value,
         wall_is_int = std::is_same<wall_t, int>::value
@@ -57,11 +69,85 @@ public:
     Q_SIGNAL void request_robot_box();
     Q_SIGNAL void request_object_box();
 
-    Q_SLOT void acquire_robot_box(const cv::Rect2d &robot_box);
-    Q_SLOT void acquire_object_box(const cv::Rect2d &object_box);
+    /**
+     * Signals emitted with the region of interest selected for the
+     * robot or object tracker, in frame coordinates.
+     */
+    Q_SIGNAL void robot_roi_selected(const cv::Rect2d &robot_box);
+    Q_SIGNAL void object_roi_selected(const cv::Rect2d &object_box);
+
+    /**
+     * Signals emitted with the filtered velocity of the robot or object,
+     * in frame pixels per second, after each box is acquired. Trackers
+     * use it to predict where to search after a failure.
+     */
+    Q_SIGNAL void robot_velocity(double vx, double vy);
+    Q_SIGNAL void object_velocity(double vx, double vy);
+
+    /**
+     * Signal emitted when a detected shape is acquired as the object,
+     * with which the object tracker can be seeded.
+     */
+    Q_SIGNAL void object_detected(const cv::Rect2d &object_box);
+
+    /**
+     * Signal emitted when the object tracker locks onto the object or
+     * lets go of it. Detection is not needed while the object is locked.
+     */
+    Q_SIGNAL void object_locked(bool locked);
+
+    /**
+     * Acquire a tracked robot or object box, and fuse it into the pose
+     * filter at the time its frame was captured.
+     *
+     * @param robot_box    tracked box in frame coordinates
+     * @param capture_time monotonic time at which the frame was captured
+     */
+    Q_SLOT void acquire_robot_box(const cv::Rect2d &robot_box, qint64 capture_time);
+    Q_SLOT void acquire_object_box(const cv::Rect2d &object_box, qint64 capture_time);
     Q_SLOT void acquire_target_box(const cv::Rect2d &target_box);
     Q_SLOT void acquire_walls(std::shared_ptr<wall_arr> &walls);
 
+    /**
+     * Acquire the object from shapes found by a detector, unless the
+     * object is already tracked. The most confident shape of the object
+     * type is taken, or of any type before the type is known, if it is
+     * at least as confident as the shape_min_confidence parameter.
+     *
+     * @param detections   shapes found in a frame
+     * @param capture_time monotonic time at which the frame was captured
+     */
+    Q_SLOT void acquire_detections(const std::vector<Detection> &detections, qint64 capture_time);
+
+    /**
+     * Ask for a region of interest to be selected on the display for
+     * a tracker, without blocking the video.
+     *
+     * @param request one of ROBOT_ROI or OBJECT_ROI
+     */
+    Q_SLOT void request_roi(int request);
+
+    /**
+     * Hand the selected region of interest to the tracker that asked
+     * for it, if any.
+     *
+     * @param roi region of interest in frame coordinates
+     */
+    Q_SLOT void select_roi(const cv::Rect2d &roi);
+
+    /**
+     * Slot called for every move commanded to the robot. While the move
+     * lasts, the robot's pose is predicted at the commanded power times
+     * the pose_command_speed parameter, in frame pixels per second per
+     * unit of power, in place of its filtered velocity. Commands are
+     * ignored if the speed is not positive.
+     *
+     * @param dx        commanded power along +X
+     * @param dy        commanded power along +Y
+     * @param step_time time in milliseconds the move is commanded for
+     */
+    Q_SLOT void command_robot(int dx, int dy, int step_time);
+
     Q_SLOT void clear_path();
     Q_SLOT void append_path(double x, double y);
 
@@ -73,6 +159,12 @@ public:
 
     const path2d &get_path() const;
 
+    /**
+     * @return a number that changes whenever the path does, so that
+     *         views can tell when to read the path again
+     */
+    std::uint64_t path_revision() const;
+
     cv::Rect2d &get_robot_box(bool consume = false);
     cv::Rect2d &get_object_box(bool consume = false);
     cv::Rect2d &get_target_box();
@@ -86,12 +178,34 @@ public:
     int object_type() const;
     void set_object_type(int object_type);
 
+    /**
+     * @return the tracker waiting for a region of interest, or NO_ROI
+     */
+    int roi_request() const;
+
     bool is_robot_box_fresh() const;
     bool is_object_box_fresh() const;
 
     bool is_robot_box_valid() const;
     bool is_object_box_valid() const;
 
+    /**
+     * Filtered estimates of the robot and object centres, fusing the
+     * tracker boxes with the commanded moves, predicted to the current
+     * time so that procedures can act between boxes.
+     *
+     * @return the pose estimate now
+     */
+    PoseEstimate robot_pose() const;
+    PoseEstimate object_pose() const;
+
+    /**
+     * @param pose a pose estimate
+     * @return whether the pose has been measured recently enough, within
+     *         the pose_max_age parameter, to be acted on
+     */
+    bool is_pose_current(const PoseEstimate &pose) const;
+
 private:
     // Pointer to MainWindow parent
     MainWindow *m_parent;
@@ -117,12 +231,14 @@ private:
     std::shared_ptr<wall_arr> m_walls;
 
     int m_object_type;
+    int m_roi_request;
 
     /**
      * The desired robot or object traversal path. Object that seek
      * to update this should modify it directly through access functions.
      */
     path2d m_path;
+    std::uint64_t m_path_revision;
 
     /**
      * Stored procedure instance for traversing the path.
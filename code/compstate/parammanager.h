@@ -70,6 +70,37 @@ public:
     MANAGE_PARAM(int, wall_penalty_1,  16)
     MANAGE_PARAM(int, wall_penalty_2,   4)
 
+    // Capture
+    MANAGE_PARAM(int, replay_pacing,    0)
+    MANAGE_PARAM(int, adaptive_capture, 1)
+
+    // Preprocessor
+    MANAGE_PARAM(int, frame_queue_policy, 0)
+    MANAGE_PARAM(int, frame_queue_slots,  1)
+    MANAGE_PARAM(int, frames_in_flight,   3)
+
+    // Recorder
+    MANAGE_PARAM(int, record_queue_policy, 0)
+    MANAGE_PARAM(int, record_queue_slots,  8)
+
+    // Instant replay
+    MANAGE_PARAM(int, replay_buffer_mb,      256)
+    MANAGE_PARAM(int, replay_buffer_seconds,  10)
+
+    // Squares
+    MANAGE_PARAM(int, square_method,  0)
+    MANAGE_PARAM(int, square_levels, 50)
+
+    // ShapeDetect
+    MANAGE_PARAM(int,    shape_denoise,          0)
+    MANAGE_PARAM(double, shape_min_confidence, 0.8)
+
+    // Pose filter
+    MANAGE_PARAM(double, pose_process_noise, 400.0)
+    MANAGE_PARAM(double, pose_measure_noise,   4.0)
+    MANAGE_PARAM(double, pose_command_speed,  10.0)
+    MANAGE_PARAM(int,    pose_max_age,         500)
+
 public:
     inline explicit param_manager(parent_t p) :
         m_p(p) {
@@ -92,6 +123,37 @@ public:
         PARAM_INIT(wall_penalty_0);
         PARAM_INIT(wall_penalty_1);
         PARAM_INIT(wall_penalty_2);
+
+        // Capture
+        PARAM_INIT(replay_pacing   )
+        PARAM_INIT(adaptive_capture)
+
+        // Preprocessor
+        PARAM_INIT(frame_queue_policy)
+        PARAM_INIT(frame_queue_slots )
+        PARAM_INIT(frames_in_flight  )
+
+        // Recorder
+        PARAM_INIT(record_queue_policy)
+        PARAM_INIT(record_queue_slots )
+
+        // Instant replay
+        PARAM_INIT(replay_buffer_mb     )
+        PARAM_INIT(replay_buffer_seconds)
+
+        // Squares
+        PARAM_INIT(square_method)
+        PARAM_INIT(square_levels)
+
+        // ShapeDetect
+        PARAM_INIT(shape_denoise       )
+        PARAM_INIT(shape_min_confidence)
+
+        // Pose filter
+        PARAM_INIT(pose_process_noise)
+        PARAM_INIT(pose_measure_noise)
+        PARAM_INIT(pose_command_speed)
+        PARAM_INIT(pose_max_age      )
     }
 
     inline ~param_manager() override {
@@ -114,6 +176,37 @@ public:
         PARAM_DEINIT(wall_penalty_0);
         PARAM_DEINIT(wall_penalty_1);
         PARAM_DEINIT(wall_penalty_2);
+
+        // Capture
+        PARAM_DEINIT(replay_pacing   )
+        PARAM_DEINIT(adaptive_capture)
+
+        // Preprocessor
+        PARAM_DEINIT(frame_queue_policy)
+        PARAM_DEINIT(frame_queue_slots )
+        PARAM_DEINIT(frames_in_flight  )
+
+        // Recorder
+        PARAM_DEINIT(record_queue_policy)
+        PARAM_DEINIT(record_queue_slots )
+
+        // Instant replay
+        PARAM_DEINIT(replay_buffer_mb     )
+        PARAM_DEINIT(replay_buffer_seconds)
+
+        // Squares
+        PARAM_DEINIT(square_method)
+        PARAM_DEINIT(square_levels)
+
+        // ShapeDetect
+        PARAM_DEINIT(shape_denoise       )
+        PARAM_DEINIT(shape_min_confidence)
+
+        // Pose filter
+        PARAM_DEINIT(pose_process_noise)
+        PARAM_DEINIT(pose_measure_noise)
+        PARAM_DEINIT(pose_command_speed)
+        PARAM_DEINIT(pose_max_age      )
     }
 };
 
@@ -0,0 +1,132 @@
+#include "posefilter.h"
+
+#include <algorithm>
+
+#define DEFAULT_PROCESS_NOISE     400.0
+#define DEFAULT_MEASUREMENT_NOISE   4.0
+// Variance of the velocity of a newly measured entity, in square
+// pixels per squared second
+#define INITIAL_VELOCITY_VARIANCE 1e4
+
+static constexpr double NS_PER_S = 1e9;
+
+PoseEstimate::PoseEstimate() :
+    time(0),
+    measured_time(0),
+    valid(false) {}
+
+cv::Rect2d PoseEstimate::box() const {
+    return {position.x - size.width / 2, position.y - size.height / 2, size.width, size.height};
+}
+
+PoseFilter::PoseFilter() :
+    m_x(),
+    m_y(),
+    m_time(0),
+    m_measured_time(0),
+    m_valid(false),
+    m_process_noise(DEFAULT_PROCESS_NOISE),
+    m_measurement_noise(DEFAULT_MEASUREMENT_NOISE) {}
+
+void PoseFilter::set_noise(double process_noise, double measurement_noise) {
+    m_process_noise = process_noise;
+    m_measurement_noise = measurement_noise;
+}
+
+void PoseFilter::measure(const cv::Rect2d &box, std::int64_t time) {
+    cv::Point2d center(box.x + box.width / 2, box.y + box.height / 2);
+    m_size = box.size();
+    if (!m_valid) {
+        m_x = {center.x, 0, m_measurement_noise, 0, INITIAL_VELOCITY_VARIANCE};
+        m_y = {center.y, 0, m_measurement_noise, 0, INITIAL_VELOCITY_VARIANCE};
+        m_time = time;
+        m_measured_time = time;
+        m_valid = true;
+        return;
+    }
+    predict(time);
+    correct_axis(m_x, center.x);
+    correct_axis(m_y, center.y);
+    m_measured_time = std::max(m_measured_time, time);
+    // Commands that have ended are part of the state now
+    m_commands.erase(std::remove_if(m_commands.begin(), m_commands.end(), [this](const Command &command) {
+        return command.end <= m_time;
+    }), m_commands.end());
+}
+
+void PoseFilter::command(const cv::Point2d &velocity, std::int64_t start, std::int64_t end) {
+    if (end <= start) { return; }
+    for (Command &running : m_commands) { running.end = std::min(running.end, start); }
+    m_commands.erase(std::remove_if(m_commands.begin(), m_commands.end(), [](const Command &command) {
+        return command.end <= command.start;
+    }), m_commands.end());
+    if (m_commands.size() >= MAX_COMMANDS) { m_commands.erase(m_commands.begin()); }
+    m_commands.push_back({velocity, start, end});
+}
+
+PoseEstimate PoseFilter::estimate(std::int64_t time) const {
+    PoseFilter predicted = *this;
+    if (m_valid) { predicted.predict(time); }
+    PoseEstimate pose;
+    pose.position = cv::Point2d(predicted.m_x.position, predicted.m_y.position);
+    pose.velocity = cv::Point2d(predicted.m_x.velocity, predicted.m_y.velocity);
+    pose.size = m_size;
+    pose.time = predicted.m_time;
+    pose.measured_time = m_measured_time;
+    pose.valid = m_valid;
+    return pose;
+}
+
+void PoseFilter::reset() {
+    m_valid = false;
+    m_commands.clear();
+}
+
+bool PoseFilter::valid() const {
+    return m_valid;
+}
+
+void PoseFilter::predict(std::int64_t time) {
+    if (time <= m_time) { return; }
+    // Displacement commanded between the last and the new time, and how
+    // long of it was commanded; commands do not overlap
+    cv::Point2d displacement;
+    std::int64_t commanded = 0;
+    for (const Command &command : m_commands) {
+        std::int64_t overlap = std::min(command.end, time) - std::max(command.start, m_time);
+        if (overlap > 0) {
+            displacement += command.velocity * (overlap / NS_PER_S);
+            commanded += overlap;
+        }
+    }
+    double dt = (time - m_time) / NS_PER_S;
+    double free_dt = (time - m_time - commanded) / NS_PER_S;
+    predict_axis(m_x, dt, free_dt, displacement.x);
+    predict_axis(m_y, dt, free_dt, displacement.y);
+    m_time = time;
+}
+
+void PoseFilter::predict_axis(Axis &axis, double dt, double free_dt, double displacement) const {
+    // Commanded motion replaces the filtered velocity while it lasts
+    axis.position += axis.velocity * free_dt + displacement;
+    // Covariance through the constant velocity model, with noise from
+    // a random acceleration
+    double q = m_process_noise;
+    axis.p00 += 2 * dt * axis.p01 + dt * dt * axis.p11 + q * dt * dt * dt / 3;
+    axis.p01 += dt * axis.p11 + q * dt * dt / 2;
+    axis.p11 += q * dt;
+}
+
+void PoseFilter::correct_axis(Axis &axis, double measured) const {
+    double innovation = measured - axis.position;
+    double s = axis.p00 + m_measurement_noise;
+    double k0 = axis.p00 / s;
+    double k1 = axis.p01 / s;
+    axis.position += k0 * innovation;
+    axis.velocity += k1 * innovation;
+    double p00 = axis.p00;
+    double p01 = axis.p01;
+    axis.p00 = (1 - k0) * p00;
+    axis.p01 = (1 - k0) * p01;
+    axis.p11 -= k1 * p01;
+}
@@ -0,0 +1,141 @@
+#ifndef MINOTAUR_CPP_POSEFILTER_H
+#define MINOTAUR_CPP_POSEFILTER_H
+
+#include <opencv2/core/types.hpp>
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * Filtered position of a tracked entity at an instant, in frame pixels.
+ */
+struct PoseEstimate {
+    PoseEstimate();
+
+    /**
+     * @return a box of the last measured size about the position
+     */
+    cv::Rect2d box() const;
+
+    // Centre of the entity
+    cv::Point2d position;
+    // Velocity in pixels per second
+    cv::Point2d velocity;
+    // Size of the last measured box
+    cv::Size2d size;
+    // Monotonic time of the estimate, in nanoseconds
+    std::int64_t time;
+    // Monotonic time of the last measurement, in nanoseconds
+    std::int64_t measured_time;
+    // Whether the entity has been measured since the filter was reset
+    bool valid;
+};
+
+/**
+ * Constant velocity Kalman filter of the centre of a tracked entity. Each
+ * axis is filtered on its own, with the position and velocity as state.
+ * Tracker boxes are fused as measurements of the position. While a motion
+ * is commanded, the position is predicted at the commanded velocity in
+ * place of the filtered one, so that the pose can be predicted at any
+ * instant between boxes.
+ *
+ * Not thread-safe.
+ */
+class PoseFilter {
+public:
+    enum {
+        // Commanded motions kept for prediction
+        MAX_COMMANDS = 64
+    };
+
+    PoseFilter();
+
+    /**
+     * @param process_noise     spectral density of the random acceleration,
+     *                          in square pixels per cubed second
+     * @param measurement_noise variance of a measured position, in
+     *                          square pixels
+     */
+    void set_noise(double process_noise, double measurement_noise);
+
+    /**
+     * Correct the estimate with a measured box.
+     *
+     * @param box  measured box in frame pixels
+     * @param time monotonic time of the measurement, in nanoseconds
+     */
+    void measure(const cv::Rect2d &box, std::int64_t time);
+
+    /**
+     * Add a motion commanded to the entity. It supersedes the motions
+     * still commanded when it starts.
+     *
+     * @param velocity expected velocity in pixels per second
+     * @param start    monotonic time the motion starts, in nanoseconds
+     * @param end      monotonic time the motion ends, in nanoseconds
+     */
+    void command(const cv::Point2d &velocity, std::int64_t start, std::int64_t end);
+
+    /**
+     * @param time monotonic time, in nanoseconds
+     * @return the pose predicted at the time, or the last corrected
+     *         pose for earlier times
+     */
+    PoseEstimate estimate(std::int64_t time) const;
+
+    /**
+     * Forget the entity, such as when its tracker stops.
+     */
+    void reset();
+
+    /**
+     * @return whether the entity has been measured
+     */
+    bool valid() const;
+
+private:
+    struct Axis {
+        double position;
+        double velocity;
+        // Covariance of the position and velocity
+        double p00;
+        double p01;
+        double p11;
+    };
+
+    struct Command {
+        cv::Point2d velocity;
+        std::int64_t start;
+        std::int64_t end;
+    };
+
+    /**
+     * Predict the state forward to a later time.
+     *
+     * @param time monotonic time, in nanoseconds
+     */
+    void predict(std::int64_t time);
+
+    /**
+     * @param axis         axis to predict
+     * @param dt           seconds to predict forward
+     * @param free_dt      seconds of those without a commanded motion
+     * @param displacement commanded displacement over the other seconds
+     */
+    void predict_axis(Axis &axis, double dt, double free_dt, double displacement) const;
+
+    void correct_axis(Axis &axis, double measured) const;
+
+    Axis m_x;
+    Axis m_y;
+    cv::Size2d m_size;
+    std::int64_t m_time;
+    std::int64_t m_measured_time;
+    bool m_valid;
+    std::vector<Command> m_commands;
+
+    double m_process_noise;
+    double m_measurement_noise;
+};
+
+#endif //MINOTAUR_CPP_POSEFILTER_H
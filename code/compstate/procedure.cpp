@@ -2,6 +2,7 @@
 #include "compstate.h"
 #include "common.h"
 #include "parammanager.h"
+#include "posefilter.h"
 
 #include "../camera/statusbox.h"
 #include "../camera/statuslabel.h"
@@ -122,15 +123,17 @@ void Procedure::movement_loop() {
         return;
     }
 
-    // If the box has not been updated, tracker has lost acquisition, skip this loop
+    // The filtered pose is predicted between tracker boxes; skip this loop
+    // only if the tracker has lost acquisition for too long
     CompetitionState &state = Main::get()->state();
+    PoseEstimate pose = state.robot_pose();
     if (
-        !state.is_robot_box_fresh() ||
+        !state.is_pose_current(pose) ||
         !state.is_robot_box_valid()
     ) { return; }
 
     // Acquire the current robot position
-    vector2d center = algo::rect_center(Main::get()->state().get_robot_box(true));
+    vector2d center(pose.position.x, pose.position.y);
     vector2d target = m_impl->path[m_impl->index];
     // Source node is either the initial position or the last node
     vector2d source = m_impl->index > 0 ? m_impl->path[m_impl->index - 1] : m_impl->initial;
@@ -81,6 +81,7 @@ void Controller::move(Dir dir, int timer) {
 
 void Controller::move(vector2i dir, int step_time) {
     __move_delegate({dir.x() * (m_invert_x ? -1 : 1), dir.y() * (m_invert_y ? -1 : 1)}, step_time);
+    Q_EMIT moved(dir.x(), dir.y(), step_time);
 }
 
 void Controller::invert_x_axis() {
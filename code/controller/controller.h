@@ -40,6 +40,16 @@ public:
 
     virtual void __move_delegate(vector2i dir, int timer) = 0;
 
+    /**
+     * Signal emitted for every commanded move, in frame directions
+     * before any axis inversion, so that the motion can be predicted.
+     *
+     * @param dx        commanded power along +X
+     * @param dy        commanded power along +Y
+     * @param step_time time in milliseconds the move is commanded for
+     */
+    Q_SIGNAL void moved(int dx, int dy, int step_time);
+
     // Key press functions
     void keyPressed(int key);
     void keyReleased(int key);
@@ -63,6 +63,12 @@ MainWindow::MainWindow() :
     // Simulator and controls
     connect(m_camera_display.get(), &CameraDisplay::camera_changed, this, &MainWindow::switchToSimulator);
     connect(ui->move_button, &QPushButton::clicked, this, &MainWindow::moveButtonClicked);
+    // Commanded moves of either controller are fused into the robot pose
+    connect(m_solenoid.get(), &Controller::moved, m_compstate.get(), &CompetitionState::command_robot);
+    connect(m_simulator.get(), &Controller::moved, m_compstate.get(), &CompetitionState::command_robot);
+    // Shapes detected in the camera frames can acquire the object
+    connect(m_camera_display.get(), &CameraDisplay::detections_found, m_compstate.get(),
+            &CompetitionState::acquire_detections);
 
     // Opening sub windows
     connect(ui->start_python_interpreter, &QAction::triggered, m_script_window.get(), &QDialog::show);
@@ -214,6 +220,10 @@ std::weak_ptr<GlobalSim> MainWindow::global_sim() const {
     return m_global_sim;
 }
 
+CameraDisplay *MainWindow::camera_display() const {
+    return m_camera_display.get();
+}
+
 CompetitionState &MainWindow::state() {
     return *m_compstate;
 }
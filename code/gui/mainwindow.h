@@ -45,6 +45,7 @@ public:
     std::weak_ptr<StatusBox> status_box() const;
     std::weak_ptr<ParameterBox> param_box() const;
     std::weak_ptr<GlobalSim> global_sim() const;
+    CameraDisplay *camera_display() const;
 
     CompetitionState &state();
 
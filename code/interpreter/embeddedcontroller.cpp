@@ -1,3 +1,4 @@
+#include "../camera/cameradisplay.h"
 #include "../compstate/compstate.h"
 #include "../controller/controller.h"
 #include "../gui/global.h"
@@ -117,6 +118,17 @@ PyObject *Embedded::emb_object_pos(PyObject *, PyObject *) {
     return pos_tuple;
 }
 
+PyObject *Embedded::emb_dump_replay(PyObject *, PyObject *args) {
+    const char *file = nullptr;
+    if (!PyArg_ParseTuple(args, "s", &file)) {
+        return PyLong_FromLong(-1);
+    }
+    // The dump is written on the instant replay thread
+    bool res = QMetaObject::invokeMethod(Main::get()->camera_display(), "request_replay_dump",
+                                         Qt::QueuedConnection, Q_ARG(QString, QString::fromUtf8(file)));
+    return PyLong_FromLong(res);
+}
+
 PyObject *Embedded::sim_reset(PyObject *, PyObject *) {
     Main::get()->global_sim().lock()->robot_reset();
     return PyLong_FromLong(true);
@@ -133,6 +145,7 @@ PyMethodDef Embedded::emb_methods[]{
     {"robot_pos",   Embedded::emb_robot_pos,   METH_VARARGS, "Get the current robot position"},
     {"object_rect", Embedded::emb_object_rect, METH_VARARGS, "Get the current object rectangle"},
     {"object_pos",  Embedded::emb_object_pos,  METH_VARARGS, "Get the current object position"},
+    {"dump_replay", Embedded::emb_dump_replay, METH_VARARGS, "Dump the instant replay buffer to a session file"},
     {nullptr,       nullptr, 0,                    nullptr}
 };
 
@@ -55,6 +55,7 @@ namespace Embedded {
     extern PyObject *emb_object_rect(PyObject *, PyObject *);
     extern PyObject *emb_robot_pos(PyObject *, PyObject *);
     extern PyObject *emb_object_pos(PyObject *, PyObject *);
+    extern PyObject *emb_dump_replay(PyObject *, PyObject *args);
     extern PyObject *sim_reset(PyObject *, PyObject *);
 
     extern PyMethodDef emb_methods[];
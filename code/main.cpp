@@ -1,19 +1,25 @@
 #include <QApplication>
 
+#include "camera/frame.h"
 #include "compstate/compstate.h"
 #include "gui/global.h"
 #include "gui/mainwindow.h"
+#include "video/detection.h"
 #include "video/modify.h"
 
 Q_DECLARE_METATYPE(cv::Rect2d);
 Q_DECLARE_METATYPE(cv::UMat);
 Q_DECLARE_METATYPE(std::shared_ptr<CompetitionState::wall_arr>);
+Q_DECLARE_METATYPE(detection_list);
 
 int main(int argc, char *argv[]) {
     qRegisterMetaType<cv::UMat>();
     qRegisterMetaType<std::shared_ptr<CompetitionState::wall_arr>>();
     qRegisterMetaType<std::shared_ptr<VideoModifier>>();
     qRegisterMetaType<cv::Rect2d>();
+    qRegisterMetaType<detection_list>();
+    qRegisterMetaType<Frame>();
+    qRegisterMetaType<FrameMeta>();
 
     QApplication app(argc, argv);
 
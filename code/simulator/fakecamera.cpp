@@ -14,14 +14,19 @@ FakeCamera::~FakeCamera() = default;
 cv::Rect2d FakeCamera::get_robot_rect() {
     double width = GlobalSim::Robot::WIDTH;
     vector2d loc;
-    if (auto lp = Main::get()->global_sim().lock()) { loc = lp->robot(); }
+    // Without a main window, such as in the benchmark, the robot stays centred
+    if (Main::get()) {
+        if (auto lp = Main::get()->global_sim().lock()) { loc = lp->robot(); }
+    }
     loc += {WIDTH / 2, HEIGHT / 2};
     return {loc.x() - width / 2, loc.y() - width / 2, width, width};
 }
 
 cv::Point2d FakeCamera::get_object_rect() {
     vector2d loc;
-    if (auto lp = Main::get()->global_sim().lock()) { loc = lp->object(); }
+    if (Main::get()) {
+        if (auto lp = Main::get()->global_sim().lock()) { loc = lp->object(); }
+    }
     loc += {WIDTH / 2, HEIGHT / 2};
     return {loc.x(), loc.y()};
 }
@@ -59,13 +64,12 @@ cv::VideoCapture &FakeCamera::operator>>(cv::Mat &) {
     return *this;
 }
 
-void gaussian_noise(cv::UMat &image) {
-    cv::UMat noise(image.size(), CV_16SC3);
-    cv::randn(noise, cv::Scalar::all(0), cv::Scalar::all(10));
-    cv::UMat temp;
-    image.convertTo(temp, CV_16SC3);
-    cv::addWeighted(temp, 1, noise, 1, 0, temp);
-    temp.convertTo(image, image.type());
+void FakeCamera::gaussian_noise(cv::UMat &image) {
+    m_noise.create(image.size(), CV_16SC3);
+    cv::randn(m_noise, cv::Scalar::all(0), cv::Scalar::all(10));
+    image.convertTo(m_noise_sum, CV_16SC3);
+    cv::add(m_noise_sum, m_noise, m_noise_sum);
+    m_noise_sum.convertTo(image, image.type());
 }
 
 cv::VideoCapture &FakeCamera::operator>>(cv::UMat &image) {
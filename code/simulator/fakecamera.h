@@ -42,7 +42,18 @@ public:
     double get(int prop_id) const override;
 
 private:
+    /**
+     * Add gaussian noise to the image using the held buffers.
+     *
+     * @param image image to which noise is added
+     */
+    void gaussian_noise(cv::UMat &image);
+
     bool m_open;
+
+    // Buffers reused by each frame's noise generation
+    cv::UMat m_noise;
+    cv::UMat m_noise_sum;
 };
 
 #endif //MINOTAUR_CPP_FAKECAMERA_H
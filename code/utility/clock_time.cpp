@@ -1,3 +1,5 @@
+#include <chrono>
+
 #include "clock_time.h"
 
 // initialize static data fields
@@ -21,3 +23,9 @@ std::string ClockTime::getCurrentTime() {
 
     return time_str;
 }
+
+std::int64_t ClockTime::monotonic_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()
+    ).count();
+}
@@ -1,6 +1,7 @@
 #ifndef CLOCK_TIME_H
 #define CLOCK_TIME_H
 
+#include <cstdint>
 #include <ctime>
 #include <string>
 
@@ -8,6 +9,14 @@ class ClockTime {
 public:
     static std::string getCurrentTime();
 
+    /**
+     * Read a monotonic clock that is unaffected by changes to the
+     * system time. Values are only meaningful relative to each other.
+     *
+     * @return monotonic time in nanoseconds
+     */
+    static std::int64_t monotonic_ns();
+
 private:
     enum {
         TIME_CHAR_BUFFER = 10
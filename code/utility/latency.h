@@ -0,0 +1,67 @@
+#ifndef MINOTAUR_CPP_LATENCY_H
+#define MINOTAUR_CPP_LATENCY_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Sliding window of the most recent latency samples from which
+ * percentiles are computed. Not thread-safe.
+ */
+class latency_window {
+public:
+    enum {
+        DEFAULT_WINDOW = 256
+    };
+
+    explicit latency_window(std::size_t window = DEFAULT_WINDOW) :
+        m_samples(window > 0 ? window : 1, 0),
+        m_next(0),
+        m_count(0) {}
+
+    /**
+     * Add a sample, replacing the oldest if the window is full.
+     *
+     * @param sample latency value
+     */
+    void add(std::int64_t sample) {
+        m_samples[m_next] = sample;
+        m_next = (m_next + 1) % m_samples.size();
+        if (m_count < m_samples.size()) { ++m_count; }
+    }
+
+    /**
+     * Nearest-rank percentile of the samples in the window.
+     *
+     * @param p percentile in [0, 100]
+     * @return the percentile value, or 0 if there are no samples
+     */
+    std::int64_t percentile(double p) const {
+        if (m_count == 0) { return 0; }
+        m_sorted.assign(m_samples.begin(), m_samples.begin() + m_count);
+        std::size_t rank = static_cast<std::size_t>(p / 100.0 * (m_count - 1) + 0.5);
+        if (rank >= m_count) { rank = m_count - 1; }
+        std::nth_element(m_sorted.begin(), m_sorted.begin() + rank, m_sorted.end());
+        return m_sorted[rank];
+    }
+
+    std::size_t count() const {
+        return m_count;
+    }
+
+    void clear() {
+        m_next = 0;
+        m_count = 0;
+    }
+
+private:
+    std::vector<std::int64_t> m_samples;
+    // Scratch buffer for percentile selection
+    mutable std::vector<std::int64_t> m_sorted;
+    std::size_t m_next;
+    std::size_t m_count;
+};
+
+#endif //MINOTAUR_CPP_LATENCY_H
@@ -0,0 +1,116 @@
+#ifndef MINOTAUR_CPP_REORDERBUFFER_H
+#define MINOTAUR_CPP_REORDERBUFFER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/**
+ * Window of elements numbered by consecutive tickets, which may be put
+ * in any order and are popped in ticket order. Used to put results that
+ * complete out of order back in sequence. Slots are allocated once, so
+ * putting and popping does not allocate. Not thread-safe.
+ *
+ * @tparam Element the buffered type; must be default constructible
+ */
+template<typename Element>
+class reorder_buffer {
+public:
+    /**
+     * @param window number of tickets that may be held past the next one
+     * @param first  ticket of the first element
+     */
+    explicit reorder_buffer(std::size_t window = 1, std::uint64_t first = 0) :
+        m_slots(window > 0 ? window : 1),
+        m_next(first),
+        m_size(0) {}
+
+    /**
+     * Place an element.
+     *
+     * @param ticket ticket of the element
+     * @param value  element to place
+     * @return false if the ticket was popped, is already held, or is
+     *         outside the window
+     */
+    bool put(std::uint64_t ticket, Element value) {
+        if (!accepts(ticket)) { return false; }
+        slot &s = m_slots[ticket % m_slots.size()];
+        if (s.full) { return false; }
+        s.value = std::move(value);
+        s.full = true;
+        ++m_size;
+        return true;
+    }
+
+    /**
+     * Pop the element with the next ticket, if it has been put.
+     *
+     * @param value element popped
+     * @return whether an element was popped
+     */
+    bool pop(Element &value) {
+        slot &s = m_slots[m_next % m_slots.size()];
+        if (!s.full) { return false; }
+        value = std::move(s.value);
+        // Do not hold on to the popped element's resources
+        s.value = Element();
+        s.full = false;
+        ++m_next;
+        --m_size;
+        return true;
+    }
+
+    /**
+     * @param ticket ticket of an element
+     * @return whether the ticket is within the window
+     */
+    bool accepts(std::uint64_t ticket) const {
+        return ticket >= m_next && ticket - m_next < m_slots.size();
+    }
+
+    /**
+     * Discard every element and restart the window.
+     *
+     * @param window number of tickets that may be held past the next one
+     * @param first  ticket of the next element
+     */
+    void reset(std::size_t window, std::uint64_t first) {
+        m_slots.assign(window > 0 ? window : 1, slot());
+        m_next = first;
+        m_size = 0;
+    }
+
+    /**
+     * @return ticket of the next element to pop
+     */
+    std::uint64_t next() const {
+        return m_next;
+    }
+
+    std::size_t window() const {
+        return m_slots.size();
+    }
+
+    /**
+     * @return number of elements held
+     */
+    std::size_t size() const {
+        return m_size;
+    }
+
+private:
+    struct slot {
+        slot() : value(), full(false) {}
+
+        Element value;
+        bool full;
+    };
+
+    std::vector<slot> m_slots;
+    std::uint64_t m_next;
+    std::size_t m_size;
+};
+
+#endif //MINOTAUR_CPP_REORDERBUFFER_H
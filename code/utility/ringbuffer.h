@@ -0,0 +1,204 @@
+#ifndef MINOTAUR_CPP_RINGBUFFER_H
+#define MINOTAUR_CPP_RINGBUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+/**
+ * Counters kept by a ring_buffer. Values are cumulative since
+ * construction or the last call to ring_buffer::reset_stats().
+ */
+struct ring_buffer_stats {
+    // Number of elements successfully placed in the buffer
+    std::size_t enqueued;
+    // Number of elements discarded because of the buffer policy
+    std::size_t dropped;
+    // Number of elements taken out of the buffer by the consumer
+    std::size_t processed;
+};
+
+/**
+ * Bounded lock-free ring buffer between a single producer and a
+ * single consumer thread.
+ *
+ * Each slot carries a sequence number which hands ownership of the slot
+ * back and forth between the producer and consumer, so an element is never
+ * written while it is being read. The sequence is twice the position, plus
+ * one while the slot holds an element, so a single slot buffer can tell a
+ * full slot apart from one free for the next lap.
+ *
+ * The DROP_OLDEST and LATEST policies have the producer evict the oldest
+ * element of a full buffer with the same compare-and-swap the consumer
+ * uses to pop, so the buffer stays lock-free.
+ *
+ * @tparam Element the buffered type; must be default constructible
+ */
+template<typename Element>
+class ring_buffer {
+public:
+    enum Policy {
+        // Single slot that always holds the newest element
+        LATEST,
+        // Elements are kept in order and new elements are
+        // rejected while the buffer is full
+        FIFO,
+        // Elements are kept in order and the oldest element is
+        // evicted to make room when the buffer is full
+        DROP_OLDEST
+    };
+
+    /**
+     * Create a ring buffer. The LATEST policy always uses a single slot.
+     *
+     * @param capacity number of slots
+     * @param policy   behaviour when the buffer is full
+     */
+    explicit ring_buffer(std::size_t capacity = 1, Policy policy = LATEST) :
+        m_capacity(policy == LATEST || capacity == 0 ? 1 : capacity),
+        m_policy(policy),
+        m_slots(new slot[m_capacity]),
+        m_head(0),
+        m_tail(0),
+        m_enqueued(0),
+        m_dropped(0),
+        m_processed(0) {
+        for (std::size_t i = 0; i < m_capacity; ++i) {
+            m_slots[i].seq.store(2 * i, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * Push an element into the buffer. Must only be called
+     * from the producer thread.
+     *
+     * @param value element to push
+     * @return true if the element was placed in the buffer
+     */
+    bool push(const Element &value) {
+        if (try_push(value)) { return true; }
+        if (m_policy != FIFO) {
+            // Evict the oldest element and try again; the consumer may
+            // have taken it first, which also frees a slot
+            Element evicted;
+            if (try_pop(evicted)) { m_dropped.fetch_add(1, std::memory_order_relaxed); }
+            if (try_push(value)) { return true; }
+        }
+        // Buffer is full or the consumer still holds the slot
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    /**
+     * Push an element only if a slot is free, whatever the policy. A
+     * failed push is not counted as a drop, so the producer may retry.
+     * Must only be called from the producer thread.
+     *
+     * @param value element to push
+     * @return true if the element was placed in the buffer
+     */
+    bool try_push(const Element &value) {
+        // Only the producer moves the head
+        std::size_t pos = m_head.load(std::memory_order_relaxed);
+        slot &s = m_slots[pos % m_capacity];
+        // The slot is free once the consumer has released it for this lap
+        if (s.seq.load(std::memory_order_acquire) != 2 * pos) { return false; }
+        s.value = value;
+        s.seq.store(2 * pos + 1, std::memory_order_release);
+        m_head.store(pos + 1, std::memory_order_release);
+        m_enqueued.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /**
+     * Pop the oldest element from the buffer. Must only be called
+     * from the consumer thread.
+     *
+     * @param value reference in which to store the element
+     * @return true if an element was popped
+     */
+    bool pop(Element &value) {
+        if (!try_pop(value)) { return false; }
+        m_processed.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /**
+     * @return an approximate count of the elements in the buffer
+     */
+    std::size_t size() const {
+        std::size_t head = m_head.load(std::memory_order_acquire);
+        std::size_t tail = m_tail.load(std::memory_order_acquire);
+        return head > tail ? head - tail : 0;
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    std::size_t capacity() const {
+        return m_capacity;
+    }
+
+    Policy policy() const {
+        return m_policy;
+    }
+
+    ring_buffer_stats stats() const {
+        return {
+            m_enqueued.load(std::memory_order_relaxed),
+            m_dropped.load(std::memory_order_relaxed),
+            m_processed.load(std::memory_order_relaxed)
+        };
+    }
+
+    void reset_stats() {
+        m_enqueued.store(0, std::memory_order_relaxed);
+        m_dropped.store(0, std::memory_order_relaxed);
+        m_processed.store(0, std::memory_order_relaxed);
+    }
+
+    // Disable copy constructor and assignment
+    ring_buffer(const ring_buffer<Element> &) = delete;
+
+    ring_buffer<Element> &operator=(const ring_buffer<Element> &) = delete;
+
+private:
+    struct slot {
+        std::atomic<std::size_t> seq;
+        Element value;
+    };
+
+    bool try_pop(Element &value) {
+        // Both the consumer and an evicting producer may move the tail
+        std::size_t pos = m_tail.load(std::memory_order_relaxed);
+        for (;;) {
+            slot &s = m_slots[pos % m_capacity];
+            std::size_t seq = s.seq.load(std::memory_order_acquire);
+            if (seq != 2 * pos + 1) {
+                // Empty, or another thread already claimed the slot
+                if (seq < 2 * pos + 1) { return false; }
+                pos = m_tail.load(std::memory_order_relaxed);
+            } else if (m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                value = std::move(s.value);
+                s.value = Element();
+                // Hand the slot back to the producer for its next lap
+                s.seq.store(2 * (pos + m_capacity), std::memory_order_release);
+                return true;
+            }
+        }
+    }
+
+    std::size_t m_capacity;
+    Policy m_policy;
+    std::unique_ptr<slot[]> m_slots;
+
+    std::atomic<std::size_t> m_head;
+    std::atomic<std::size_t> m_tail;
+
+    std::atomic<std::size_t> m_enqueued;
+    std::atomic<std::size_t> m_dropped;
+    std::atomic<std::size_t> m_processed;
+};
+
+#endif //MINOTAUR_CPP_RINGBUFFER_H
@@ -0,0 +1,83 @@
+#ifndef MINOTAUR_CPP_THREADPOOL_H
+#define MINOTAUR_CPP_THREADPOOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Fixed set of worker threads that run posted tasks in FIFO order.
+ * Pending tasks are run before the pool is destroyed.
+ */
+class thread_pool {
+public:
+    typedef std::function<void()> task;
+
+    explicit thread_pool(std::size_t threads) :
+        m_stopping(false) {
+        if (threads == 0) { threads = 1; }
+        m_workers.reserve(threads);
+        for (std::size_t i = 0; i < threads; ++i) {
+            m_workers.emplace_back(&thread_pool::work, this);
+        }
+    }
+
+    ~thread_pool() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_ready.notify_all();
+        for (std::thread &worker : m_workers) { worker.join(); }
+    }
+
+    thread_pool(const thread_pool &) = delete;
+    thread_pool &operator=(const thread_pool &) = delete;
+
+    /**
+     * Queue a task to be run on one of the workers.
+     *
+     * @param t task to run
+     */
+    void post(task t) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_tasks.push_back(std::move(t));
+        }
+        m_ready.notify_one();
+    }
+
+    /**
+     * @return number of worker threads
+     */
+    std::size_t size() const {
+        return m_workers.size();
+    }
+
+private:
+    void work() {
+        for (;;) {
+            task t;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_ready.wait(lock, [this] { return m_stopping || !m_tasks.empty(); });
+                if (m_tasks.empty()) { return; }
+                t = std::move(m_tasks.front());
+                m_tasks.pop_front();
+            }
+            t();
+        }
+    }
+
+    std::vector<std::thread> m_workers;
+    std::deque<task> m_tasks;
+    std::mutex m_mutex;
+    std::condition_variable m_ready;
+    bool m_stopping;
+};
+
+#endif //MINOTAUR_CPP_THREADPOOL_H
@@ -0,0 +1,96 @@
+#ifndef MINOTAUR_CPP_TURNSTILE_H
+#define MINOTAUR_CPP_TURNSTILE_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+/**
+ * Lets threads holding consecutive tickets through one at a time, in
+ * ticket order. Used where frames processed at once on several threads
+ * have a step that must see the frames in the order they were taken.
+ * Every ticket must pass, or the tickets after it wait forever.
+ */
+class turnstile {
+public:
+    /**
+     * Waits for the turn of a ticket when constructed and lets the next
+     * ticket through when destroyed, also if an exception is thrown.
+     */
+    class guard {
+    public:
+        guard(turnstile &gate, std::uint64_t ticket) :
+            m_gate(gate),
+            m_ticket(ticket) {
+            m_gate.wait(ticket);
+        }
+
+        ~guard() {
+            m_gate.pass(m_ticket);
+        }
+
+        guard(const guard &) = delete;
+        guard &operator=(const guard &) = delete;
+
+    private:
+        turnstile &m_gate;
+        std::uint64_t m_ticket;
+    };
+
+    /**
+     * @param first ticket let through first
+     */
+    explicit turnstile(std::uint64_t first = 0) :
+        m_next(first) {}
+
+    turnstile(const turnstile &) = delete;
+    turnstile &operator=(const turnstile &) = delete;
+
+    /**
+     * Block until every ticket before this one has passed.
+     *
+     * @param ticket ticket of the caller
+     */
+    void wait(std::uint64_t ticket) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_turn.wait(lock, [this, ticket] { return m_next == ticket; });
+    }
+
+    /**
+     * Let the next ticket through, after wait() has returned.
+     *
+     * @param ticket ticket of the caller
+     */
+    void pass(std::uint64_t ticket) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_next = ticket + 1;
+        }
+        m_turn.notify_all();
+    }
+
+    /**
+     * Start again from a ticket. No thread may be waiting.
+     *
+     * @param first ticket let through first
+     */
+    void reset(std::uint64_t first = 0) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_next = first;
+    }
+
+    /**
+     * @return ticket let through next
+     */
+    std::uint64_t next() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_next;
+    }
+
+private:
+    mutable std::mutex m_mutex;
+    std::condition_variable m_turn;
+    std::uint64_t m_next;
+};
+
+#endif //MINOTAUR_CPP_TURNSTILE_H
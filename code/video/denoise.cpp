@@ -0,0 +1,57 @@
+#include <opencv2/imgproc.hpp>
+#include <opencv2/photo.hpp>
+
+#include "denoise.h"
+
+Denoiser::Denoiser(int method) :
+    m_method(method >= 0 && method < NUM_METHODS ? method : NON_LOCAL_MEANS) {}
+
+void Denoiser::apply(const cv::UMat &gray, cv::UMat &dst) {
+    switch (m_method) {
+        case NON_LOCAL_MEANS:
+            //(input, output, filter strength, template window size, search window size)
+            cv::fastNlMeansDenoising(gray, dst, 35, 10, 21);
+            break;
+        case GAUSSIAN:
+            cv::GaussianBlur(gray, dst, cv::Size(GAUSSIAN_KERNEL, GAUSSIAN_KERNEL), 0);
+            break;
+        case MEDIAN:
+            cv::medianBlur(gray, dst, MEDIAN_KERNEL);
+            break;
+        default:
+            accumulate(gray);
+            m_average.convertTo(dst, CV_8U);
+            break;
+    }
+}
+
+void Denoiser::accumulate(const cv::UMat &gray) {
+    if (m_average.size() != gray.size()) {
+        gray.convertTo(m_average, CV_32F);
+    } else {
+        cv::accumulateWeighted(gray, m_average, TEMPORAL_WEIGHT_PERCENT / 100.0);
+    }
+}
+
+void Denoiser::reset() {
+    m_average.release();
+}
+
+int Denoiser::method() const {
+    return m_method;
+}
+
+const char *Denoiser::name(int method) {
+    switch (method) {
+        case NON_LOCAL_MEANS:
+            return "non-local means";
+        case TEMPORAL:
+            return "temporal";
+        case GAUSSIAN:
+            return "gaussian";
+        case MEDIAN:
+            return "median";
+        default:
+            return "unknown";
+    }
+}
@@ -0,0 +1,75 @@
+#ifndef MINOTAUR_CPP_DENOISE_H
+#define MINOTAUR_CPP_DENOISE_H
+
+#include <opencv2/core/core.hpp>
+
+/**
+ * Noise filter applied to the grayscale frame before edge detection.
+ * The methods trade quality for cost: non-local means is the cleanest and
+ * by far the slowest, while the others run in a small fraction of a frame
+ * interval. Every method runs on cv::UMat, and so is vectorized or
+ * offloaded by OpenCV.
+ */
+class Denoiser {
+public:
+    enum Method {
+        // Non-local means with a 21 pixel search window
+        NON_LOCAL_MEANS,
+        // Recursive average over consecutive frames, which removes sensor
+        // noise without blurring edges that do not move, but smears the
+        // edges of moving shapes
+        TEMPORAL,
+        // Separable Gaussian blur
+        GAUSSIAN,
+        // Median filter, which keeps edges sharp
+        MEDIAN,
+        NUM_METHODS
+    };
+
+    enum {
+        // Weight of the newest frame in the temporal average, in percent
+        TEMPORAL_WEIGHT_PERCENT = 40,
+        // Kernel sizes of the spatial filters
+        GAUSSIAN_KERNEL = 5,
+        MEDIAN_KERNEL = 5
+    };
+
+    /**
+     * @param method one of the denoise methods, non-local means if unknown
+     */
+    explicit Denoiser(int method = NON_LOCAL_MEANS);
+
+    /**
+     * Denoise a grayscale frame. The temporal average is restarted when
+     * the frame size changes.
+     *
+     * @param gray grayscale frame
+     * @param dst  denoised frame
+     */
+    void apply(const cv::UMat &gray, cv::UMat &dst);
+
+    /**
+     * Forget the previous frames of the temporal average.
+     */
+    void reset();
+
+    /**
+     * @return the denoise method
+     */
+    int method() const;
+
+    /**
+     * @param method one of the denoise methods
+     * @return the name of the method
+     */
+    static const char *name(int method);
+
+private:
+    void accumulate(const cv::UMat &gray);
+
+    int m_method;
+    // Running average of the frames, in floating point
+    cv::UMat m_average;
+};
+
+#endif //MINOTAUR_CPP_DENOISE_H
@@ -0,0 +1,26 @@
+#ifndef MINOTAUR_CPP_DETECTION_H
+#define MINOTAUR_CPP_DETECTION_H
+
+#include <opencv2/core/types.hpp>
+
+#include <vector>
+
+/**
+ * A shape found by a detector, published to the CompetitionState so that
+ * the object can be acquired, and a tracker seeded, without selecting it
+ * by hand. Coordinates are frame pixels before rotation and zoom, as for
+ * tracker boxes.
+ */
+struct Detection {
+    // One of the CompetitionState object types
+    int type;
+    // Centre of mass of the shape outline
+    cv::Point2d centroid;
+    cv::Rect2d box;
+    // How closely the outline matches the ideal shape, in [0, 1]
+    double confidence;
+};
+
+typedef std::vector<Detection> detection_list;
+
+#endif //MINOTAUR_CPP_DETECTION_H
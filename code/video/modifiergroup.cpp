@@ -0,0 +1,58 @@
+#include "modifiergroup.h"
+#include "../camera/framegraph.h"
+
+ModifierGroup::ModifierGroup(std::vector<std::shared_ptr<VideoModifier>> modifiers) :
+    m_modifiers(std::move(modifiers)) {}
+
+void ModifierGroup::detect(const cv::UMat &img, ImagePyramid &pyramid) {
+    for (const std::shared_ptr<VideoModifier> &modifier : m_modifiers) {
+        modifier->gated_detect(img, pyramid, capture_time());
+    }
+}
+
+void ModifierGroup::draw(cv::UMat &img, annotation_list &annotations) {
+    for (const std::shared_ptr<VideoModifier> &modifier : m_modifiers) {
+        modifier->draw(img, annotations);
+    }
+}
+
+void ModifierGroup::report(FrameMeta &meta) {
+    for (const std::shared_ptr<VideoModifier> &modifier : m_modifiers) {
+        modifier->report(meta);
+    }
+}
+
+std::size_t ModifierGroup::add_nodes(FrameGraph &graph, const std::vector<std::size_t> &inputs) {
+    // Detection branches of every modifier
+    std::vector<std::size_t> branches = add_detect_nodes(graph, inputs);
+    if (branches.empty()) { branches = inputs; }
+    // Join the branches before drawing on the frame
+    return graph.add_node("draw", [this](FrameContext &context) {
+        draw(context.frame.image, context.frame.meta.annotate());
+        report(context.frame.meta);
+    }, branches);
+}
+
+std::vector<std::size_t> ModifierGroup::add_detect_nodes(FrameGraph &graph, const std::vector<std::size_t> &inputs) {
+    std::vector<std::size_t> branches;
+    for (const std::shared_ptr<VideoModifier> &modifier : m_modifiers) {
+        std::vector<std::size_t> added = modifier->add_detect_nodes(graph, inputs);
+        branches.insert(branches.end(), added.begin(), added.end());
+    }
+    return branches;
+}
+
+std::shared_ptr<VideoModifier> ModifierGroup::clone() {
+    std::vector<std::shared_ptr<VideoModifier>> clones;
+    for (const std::shared_ptr<VideoModifier> &modifier : m_modifiers) {
+        clones.push_back(modifier->clone());
+        if (!clones.back()) { return nullptr; }
+    }
+    return std::make_shared<ModifierGroup>(std::move(clones));
+}
+
+void ModifierGroup::register_actions(ActionBox *box) {
+    for (const std::shared_ptr<VideoModifier> &modifier : m_modifiers) {
+        modifier->register_actions(box);
+    }
+}
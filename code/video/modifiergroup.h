@@ -0,0 +1,36 @@
+#ifndef MINOTAUR_CPP_MODIFIERGROUP_H
+#define MINOTAUR_CPP_MODIFIERGROUP_H
+
+#include "modify.h"
+
+/**
+ * A set of modifiers run on the same frame. In a FrameGraph each modifier
+ * detects on its own branch, concurrently with the others, and the
+ * branches join before the results are drawn and published in order.
+ */
+class ModifierGroup : public VideoModifier {
+public:
+    explicit ModifierGroup(std::vector<std::shared_ptr<VideoModifier>> modifiers);
+
+    void detect(const cv::UMat &img, ImagePyramid &pyramid) override;
+
+    void draw(cv::UMat &img, annotation_list &annotations) override;
+
+    void report(FrameMeta &meta) override;
+
+    std::size_t add_nodes(FrameGraph &graph, const std::vector<std::size_t> &inputs) override;
+
+    std::vector<std::size_t> add_detect_nodes(FrameGraph &graph, const std::vector<std::size_t> &inputs) override;
+
+    void register_actions(ActionBox *box) override;
+
+    /**
+     * The group can be cloned only if every modifier in it can.
+     */
+    std::shared_ptr<VideoModifier> clone() override;
+
+private:
+    std::vector<std::shared_ptr<VideoModifier>> m_modifiers;
+};
+
+#endif //MINOTAUR_CPP_MODIFIERGROUP_H
@@ -1,5 +1,8 @@
 #include "modify.h"
+#include "motiongate.h"
+#include "pyramid.h"
 
+#include "modifiergroup.h"
 #include "squares.h"
 #include "shapedetect.h"
 
@@ -7,15 +10,80 @@
 #include "tracker.h"
 #endif
 
+#include "../camera/framegraph.h"
+#include "../compstate/parammanager.h"
+#include "../utility/clock_time.h"
+#include "../utility/turnstile.h"
+#include "../utility/utility.h"
+
+#include <atomic>
+
+/**
+ * Motion gate of a modifier and its clones, and the results of the last
+ * frame they handed on. Clones pass each step in ticket order: the
+ * gating turnstile orders the comparisons with the motion reference,
+ * and the publishing turnstile the results.
+ */
+struct GateSequence {
+    GateSequence() :
+        reset(false) {}
+
+    /**
+     * Compare a frame with the reference, forgetting the reference first
+     * if a reset was requested.
+     *
+     * @param pyramid pyramid of the frame
+     * @return the detection to run on the frame
+     */
+    MotionGate::Action update(ImagePyramid &pyramid) {
+        if (reset.exchange(false)) { gate.reset(); }
+        return gate.update(pyramid);
+    }
+
+    /**
+     * Start the tickets again from zero and detect the next frame whole.
+     */
+    void restart() {
+        gating.reset();
+        publishing.reset();
+        reset = true;
+    }
+
+    MotionGate gate;
+    // Set by reset_motion_gate(), possibly from a frame out of order
+    std::atomic<bool> reset;
+    turnstile gating;
+    turnstile publishing;
+    // Results of the last frame, once the modifier has been cloned
+    std::shared_ptr<VideoModifier> results;
+};
+
+VideoModifier::VideoModifier() :
+    m_capture_time(0) {}
+
+VideoModifier::~VideoModifier() = default;
+
+// Denoise method of the shape detectors
+static int shape_denoise() {
+    return g_pm ? g_pm->shape_denoise : static_cast<int>(Denoiser::NON_LOCAL_MEANS);
+}
+
 std::shared_ptr<VideoModifier> VideoModifier::get_modifier(int modifier) {
     switch (modifier) {
         case SQUARES:
-            return std::make_shared<Squares>();
+            if (!g_pm) { return std::make_shared<Squares>(); }
+            return std::make_shared<Squares>(g_pm->square_method, g_pm->square_levels);
         case SHAPEDETECT:
-            return std::make_shared<ShapeDetect>();
+            return std::make_shared<ShapeDetect>(shape_denoise());
 #ifndef TRACKER_OFF
         case OBJTRACK:
             return std::make_shared<TrackerModifier>();
+        case SHAPETRACK:
+            // Shape detection and tracking on concurrent branches
+            return std::make_shared<ModifierGroup>(std::vector<std::shared_ptr<VideoModifier>>{
+                std::make_shared<ShapeDetect>(shape_denoise()),
+                std::make_shared<TrackerModifier>()
+            });
 #endif
         default:
             return nullptr;
@@ -28,7 +96,132 @@ void VideoModifier::add_modifier_list(QComboBox *list) {
     list->addItem("Shape Detector");
 #ifndef TRACKER_OFF
     list->addItem("Object Tracker");
+    list->addItem("Shapes and Tracker");
 #endif
 }
 
+void VideoModifier::modify(cv::UMat &img) {
+    ImagePyramid pyramid(img);
+    annotation_list annotations;
+    modify(img, pyramid, annotations, ClockTime::monotonic_ns());
+    draw_annotations(img, annotations);
+}
+
+void VideoModifier::modify(cv::UMat &img, ImagePyramid &pyramid, annotation_list &annotations, std::int64_t capture_time) {
+    gated_detect(img, pyramid, capture_time);
+    draw(img, annotations);
+}
+
+bool VideoModifier::motion_gated() const {
+    return false;
+}
+
+void VideoModifier::detect_regions(const cv::UMat &img, ImagePyramid &pyramid, const std::vector<cv::Rect> &) {
+    detect(img, pyramid);
+}
+
+void VideoModifier::gated_detect(const cv::UMat &img, ImagePyramid &pyramid, std::int64_t capture_time) {
+    gated_detect(img, pyramid, capture_time, FrameContext::UNORDERED);
+}
+
+void VideoModifier::gated_detect(const cv::UMat &img, ImagePyramid &pyramid, std::int64_t capture_time, std::uint64_t ticket) {
+    m_capture_time = capture_time;
+    if (!motion_gated()) {
+        detect(img, pyramid);
+        return;
+    }
+    if (!m_sequence) { m_sequence = std::make_shared<GateSequence>(); }
+    GateSequence &sequence = *m_sequence;
+    if (ticket == FrameContext::UNORDERED) {
+        // Continue from the last results of the clones, if there were any
+        if (sequence.results) {
+            copy_results(*sequence.results);
+            sequence.results.reset();
+        }
+        prepare(img, pyramid);
+        switch (sequence.update(pyramid)) {
+            case MotionGate::REUSE:
+                break;
+            case MotionGate::DETECT_REGIONS:
+                detect_regions(img, pyramid, sequence.gate.regions());
+                break;
+            default:
+                detect(img, pyramid);
+                break;
+        }
+        return;
+    }
+    MotionGate::Action action = MotionGate::DETECT;
+    std::vector<cv::Rect> regions;
+    try {
+        {
+            turnstile::guard turn(sequence.gating, ticket);
+            prepare(img, pyramid);
+            action = sequence.update(pyramid);
+            regions = sequence.gate.regions();
+        }
+        // Frames detected whole do not depend on the frames before them
+        if (action == MotionGate::DETECT) { detect(img, pyramid); }
+    } catch (...) {
+        // Let the frames after this one continue from the frame before
+        turnstile::guard turn(sequence.publishing, ticket);
+        throw;
+    }
+    turnstile::guard turn(sequence.publishing, ticket);
+    if (action == MotionGate::DETECT) {
+        sequence.results->copy_results(*this);
+        return;
+    }
+    // The results of the frame before are valid outside the regions
+    copy_results(*sequence.results);
+    if (action == MotionGate::DETECT_REGIONS) {
+        detect_regions(img, pyramid, regions);
+        sequence.results->copy_results(*this);
+    }
+}
+
+void VideoModifier::reset_motion_gate() {
+    if (m_sequence) { m_sequence->reset = true; }
+}
+
+std::int64_t VideoModifier::capture_time() const {
+    return m_capture_time;
+}
+
+void VideoModifier::copy_results(const VideoModifier &) {}
+
+void VideoModifier::prepare(const cv::UMat &, ImagePyramid &) {}
+
+void VideoModifier::draw(cv::UMat &, annotation_list &) {}
+
+void VideoModifier::report(FrameMeta &) {}
+
+std::size_t VideoModifier::add_nodes(FrameGraph &graph, const std::vector<std::size_t> &inputs) {
+    return graph.add_node("modify", [this](FrameContext &context) {
+        gated_detect(context.frame.image, context.pyramid, context.frame.meta.capture_time, context.ticket);
+        draw(context.frame.image, context.frame.meta.annotate());
+        report(context.frame.meta);
+    }, inputs);
+}
+
+std::vector<std::size_t> VideoModifier::add_detect_nodes(FrameGraph &graph, const std::vector<std::size_t> &inputs) {
+    return {graph.add_node("detect", [this](FrameContext &context) {
+        gated_detect(context.frame.image, context.pyramid, context.frame.meta.capture_time, context.ticket);
+    }, inputs)};
+}
+
+std::shared_ptr<VideoModifier> VideoModifier::clone() {
+    std::shared_ptr<VideoModifier> clone = create();
+    if (!clone || !motion_gated()) { return clone; }
+    if (!m_sequence) { m_sequence = std::make_shared<GateSequence>(); }
+    if (!m_sequence->results) { m_sequence->results = create(); }
+    m_sequence->restart();
+    clone->m_sequence = m_sequence;
+    return clone;
+}
+
+std::shared_ptr<VideoModifier> VideoModifier::create() const {
+    return nullptr;
+}
+
 void VideoModifier::register_actions(ActionBox *) {}
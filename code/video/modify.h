@@ -1,7 +1,9 @@
 #ifndef MINOTAUR_CPP_MODIFY_H
 #define MINOTAUR_CPP_MODIFY_H
 
+#include <cstdint>
 #include <memory>
+#include <vector>
 
 #include <opencv2/core/core.hpp>
 
@@ -9,6 +11,12 @@
 #include <QComboBox>
 
 #include "../camera/actionbox.h"
+#include "../camera/annotation.h"
+
+class FrameGraph;
+class ImagePyramid;
+struct FrameMeta;
+struct GateSequence;
 
 class VideoModifier : public QObject {
 public:
@@ -16,16 +24,204 @@ public:
         NONE = 0,
         SQUARES = 1,
         SHAPEDETECT = 2,
-        OBJTRACK = 3
+        OBJTRACK = 3,
+        SHAPETRACK = 4
     };
 
+    VideoModifier();
+    ~VideoModifier() override;
+
     static std::shared_ptr<VideoModifier> get_modifier(int modifier);
 
     static void add_modifier_list(QComboBox *list);
 
-    virtual void modify(cv::UMat &img) = 0;
+    /**
+     * Modify the frame, building a pyramid for it. Without a display to
+     * overlay them, annotations are drawn onto the frame, which is taken
+     * to have been captured now.
+     *
+     * @param img frame to modify
+     */
+    virtual void modify(cv::UMat &img);
+
+    /**
+     * Modify the frame, with access to its shared pyramid so that
+     * downsampled and grayscale levels are computed once per frame.
+     * By default runs gated_detect() and then draw().
+     *
+     * @param img          frame to modify
+     * @param pyramid      pyramid of the unmodified frame
+     * @param annotations  annotations drawn over the frame
+     * @param capture_time monotonic time at which the frame was captured
+     */
+    virtual void modify(cv::UMat &img, ImagePyramid &pyramid, annotation_list &annotations, std::int64_t capture_time);
+
+    /**
+     * Analyse the frame without writing to it. Modifiers on separate
+     * branches of a FrameGraph run this concurrently on the same frame.
+     *
+     * @param img     frame to analyse
+     * @param pyramid pyramid of the frame
+     */
+    virtual void detect(const cv::UMat &img, ImagePyramid &pyramid) = 0;
+
+    /**
+     * Whether the results of detect() depend only on the pixels they
+     * were found in, and so stay valid while those pixels do not change.
+     * Such modifiers are gated by motion: detection is skipped on frames
+     * where nothing has moved, and runs in detect_regions() when only
+     * part of the frame has changed. False by default.
+     *
+     * @return whether detection is gated by motion
+     */
+    virtual bool motion_gated() const;
+
+    /**
+     * Detect again inside regions of the frame, replacing the results
+     * found there before and keeping the others. Regions may need to
+     * grow to contain whole results, see MotionGate::cover(). By default
+     * detects over the whole frame.
+     *
+     * @param img     frame to analyse
+     * @param pyramid pyramid of the frame
+     * @param regions changed regions of the frame
+     */
+    virtual void detect_regions(const cv::UMat &img, ImagePyramid &pyramid, const std::vector<cv::Rect> &regions);
+
+    /**
+     * Run detect() or, for modifiers gated by motion, skip it or narrow
+     * it to the changed regions of the frame. Called in place of detect()
+     * by modify() and the frame graph, one frame at a time.
+     *
+     * @param img          frame to analyse
+     * @param pyramid      pyramid of the frame
+     * @param capture_time monotonic time at which the frame was captured
+     */
+    void gated_detect(const cv::UMat &img, ImagePyramid &pyramid, std::int64_t capture_time);
+
+    /**
+     * Run gated_detect() on a frame in flight alongside others on clones
+     * of the modifier. Frames are compared with the motion reference in
+     * ticket order, and those detected whole run concurrently. Frames
+     * that reuse or narrow the results of the frame before them wait for
+     * it, and the results are handed on in ticket order.
+     *
+     * @param img          frame to analyse
+     * @param pyramid      pyramid of the frame
+     * @param capture_time monotonic time at which the frame was captured
+     * @param ticket       order of the frame, see FrameContext::ticket
+     */
+    void gated_detect(const cv::UMat &img, ImagePyramid &pyramid, std::int64_t capture_time, std::uint64_t ticket);
+
+    /**
+     * Add the results of the last detect() to the annotations of the
+     * frame, which the display draws over it. Only changes that belong in
+     * the frame pixels should be drawn on the frame. Runs once every
+     * branch has joined.
+     *
+     * @param img         frame to draw on
+     * @param annotations annotations drawn over the frame
+     */
+    virtual void draw(cv::UMat &img, annotation_list &annotations);
+
+    /**
+     * Add the results of the last detect() to the metadata of the frame
+     * they were found on, which the preprocessor publishes in frame order
+     * once the frame is processed. Runs after draw(). Does nothing by
+     * default.
+     *
+     * @param meta metadata of the frame
+     */
+    virtual void report(FrameMeta &meta);
+
+    /**
+     * Add the nodes that run this modifier to a frame graph. By default
+     * a single node runs gated_detect(), draw() and report().
+     *
+     * @param graph  graph to add to
+     * @param inputs nodes that must run before the modifier
+     * @return the node that completes the modifier
+     */
+    virtual std::size_t add_nodes(FrameGraph &graph, const std::vector<std::size_t> &inputs);
+
+    /**
+     * Add the nodes that detect for this modifier to a frame graph,
+     * without drawing. Modifiers whose detection splits into independent
+     * parts add a branch for each, which run concurrently. By default a
+     * single node runs gated_detect().
+     *
+     * @param graph  graph to add to
+     * @param inputs nodes that must run before detection
+     * @return the nodes that complete detection, to be joined by draw()
+     */
+    virtual std::vector<std::size_t> add_detect_nodes(FrameGraph &graph, const std::vector<std::size_t> &inputs);
+
+    /**
+     * Create a modifier that processes frames alongside this one, so
+     * that the preprocessor runs several frames at once. Modifiers gated
+     * by motion share their motion gate, and the results of the last
+     * frame, with their clones; each frame then runs gated_detect() with
+     * its ticket. Cloning restarts the tickets at zero and detects the
+     * next frame whole, so it must not overlap processing. By default
+     * returns the modifier made by create().
+     *
+     * @return a new modifier, or nullptr if frames must run one at a time
+     */
+    virtual std::shared_ptr<VideoModifier> clone();
 
     virtual void register_actions(ActionBox *box);
+
+protected:
+    /**
+     * Create a modifier with the same settings and no results. Only
+     * modifiers whose results depend on nothing but the frames, in order,
+     * can be created; stateful modifiers, such as trackers, return
+     * nullptr, which is the default.
+     *
+     * @return a new modifier, or nullptr if frames must run one at a time
+     */
+    virtual std::shared_ptr<VideoModifier> create() const;
+
+    /**
+     * Replace the results with those of another modifier of the same
+     * type, for modifiers gated by motion that are cloned. Frames that
+     * reuse or narrow the results of the frame before them continue from
+     * results copied off the clone that detected it. Does nothing by
+     * default.
+     *
+     * @param from modifier made by create()
+     */
+    virtual void copy_results(const VideoModifier &from);
+
+    /**
+     * Called by gated_detect() on every frame, in frame order, before the
+     * frame is compared with the motion reference, for modifiers that
+     * keep state of their own across frames. Clones run it one frame at a
+     * time, so it should be cheap. Does nothing by default.
+     *
+     * @param img     frame to analyse
+     * @param pyramid pyramid of the frame
+     */
+    virtual void prepare(const cv::UMat &img, ImagePyramid &pyramid);
+
+    /**
+     * Forget the frame that motion is measured against, so that the
+     * next gated detection runs over the whole frame.
+     */
+    void reset_motion_gate();
+
+    /**
+     * @return monotonic time at which the frame being analysed by the
+     *         last gated_detect() was captured
+     */
+    std::int64_t capture_time() const;
+
+private:
+    // Set by gated_detect() before detecting
+    std::int64_t m_capture_time;
+
+    // Created on the first gated detection or clone, and shared by clones
+    std::shared_ptr<GateSequence> m_sequence;
 };
 
 Q_DECLARE_METATYPE(std::shared_ptr<VideoModifier>);
@@ -0,0 +1,98 @@
+#include <opencv2/imgproc.hpp>
+
+#include "motiongate.h"
+#include "pyramid.h"
+
+// Full resolution pixels per quarter resolution pixel
+static constexpr int QUARTER_SCALE = 4;
+
+// Merge rectangles that overlap until none do
+static void merge_overlapping(std::vector<cv::Rect> &rects) {
+    for (bool merged = true; merged;) {
+        merged = false;
+        for (std::size_t i = 0; i < rects.size() && !merged; ++i) {
+            for (std::size_t j = i + 1; j < rects.size() && !merged; ++j) {
+                if ((rects[i] & rects[j]).area() == 0) { continue; }
+                rects[i] |= rects[j];
+                rects.erase(rects.begin() + j);
+                merged = true;
+            }
+        }
+    }
+}
+
+MotionGate::Action MotionGate::update(ImagePyramid &pyramid) {
+    m_regions.clear();
+    const cv::UMat &gray = pyramid.gray(ImagePyramid::QUARTER);
+    if (gray.empty()) { return DETECT; }
+    if (m_reference.size() != gray.size()) {
+        gray.copyTo(m_reference);
+        return DETECT;
+    }
+    // Mark the changed pixels and average them over each tile
+    cv::absdiff(gray, m_reference, m_changed);
+    cv::threshold(m_changed, m_changed, PIXEL_THRESHOLD, 255, cv::THRESH_BINARY);
+    cv::Size tiles((gray.cols + TILE_SIZE - 1) / TILE_SIZE, (gray.rows + TILE_SIZE - 1) / TILE_SIZE);
+    cv::Mat tile_changed;
+    cv::resize(m_changed, tile_changed, tiles, 0, 0, cv::INTER_AREA);
+    cv::threshold(tile_changed, tile_changed, 255 * TILE_CHANGED_PERCENT / 100, 255, cv::THRESH_BINARY);
+    int changed = cv::countNonZero(tile_changed);
+    if (changed == 0) { return REUSE; }
+    if (changed * 100 > tiles.area() * FULL_DETECT_PERCENT) {
+        gray.copyTo(m_reference);
+        return DETECT;
+    }
+
+    // Group the changed tiles, with a margin of one tile so that
+    // objects which moved are inside the regions
+    cv::dilate(tile_changed, tile_changed, cv::Mat());
+    cv::Mat labels;
+    cv::Mat stats;
+    cv::Mat centroids;
+    int count = cv::connectedComponentsWithStats(tile_changed, labels, stats, centroids, 8);
+    std::vector<cv::Rect> tile_regions;
+    for (int i = 1; i < count; ++i) {
+        tile_regions.emplace_back(
+            stats.at<int>(i, cv::CC_STAT_LEFT), stats.at<int>(i, cv::CC_STAT_TOP),
+            stats.at<int>(i, cv::CC_STAT_WIDTH), stats.at<int>(i, cv::CC_STAT_HEIGHT));
+    }
+    merge_overlapping(tile_regions);
+
+    cv::Rect quarter_frame(cv::Point(), gray.size());
+    cv::Rect frame(cv::Point(), pyramid.color(ImagePyramid::FULL).size());
+    for (const cv::Rect &tile_region : tile_regions) {
+        cv::Rect quarter = cv::Rect(
+            tile_region.x * TILE_SIZE, tile_region.y * TILE_SIZE,
+            tile_region.width * TILE_SIZE, tile_region.height * TILE_SIZE) & quarter_frame;
+        // Detection runs again in the region, so its reference moves on
+        gray(quarter).copyTo(m_reference(quarter));
+        m_regions.push_back(cv::Rect(
+            quarter.x * QUARTER_SCALE, quarter.y * QUARTER_SCALE,
+            quarter.width * QUARTER_SCALE, quarter.height * QUARTER_SCALE) & frame);
+    }
+    return DETECT_REGIONS;
+}
+
+const std::vector<cv::Rect> &MotionGate::regions() const {
+    return m_regions;
+}
+
+void MotionGate::reset() {
+    m_reference.release();
+    m_regions.clear();
+}
+
+cv::Rect MotionGate::cover(cv::Rect region, const std::vector<cv::Rect> &boxes, std::vector<bool> &covered) {
+    covered.assign(boxes.size(), false);
+    // Growing the region can make it intersect more boxes
+    for (bool grown = true; grown;) {
+        grown = false;
+        for (std::size_t i = 0; i < boxes.size(); ++i) {
+            if (covered[i] || (region & boxes[i]).area() == 0) { continue; }
+            region |= boxes[i];
+            covered[i] = true;
+            grown = true;
+        }
+    }
+    return region;
+}
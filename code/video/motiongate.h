@@ -0,0 +1,79 @@
+#ifndef MINOTAUR_CPP_MOTIONGATE_H
+#define MINOTAUR_CPP_MOTIONGATE_H
+
+#include <opencv2/core/core.hpp>
+#include <vector>
+
+class ImagePyramid;
+
+/**
+ * Cheap frame differencing on the quarter resolution grayscale level,
+ * used to skip detection, or narrow it to the changed parts of the frame,
+ * in modifiers whose results depend only on the frame.
+ *
+ * The frame is divided into tiles and compared with the reference, the
+ * pixels the current results were detected on. A tile has changed when
+ * enough of its pixels differ. The reference is only updated where
+ * detection runs again, so slow changes accumulate until they are seen.
+ */
+class MotionGate {
+public:
+    enum Action {
+        // No reference yet or too much has changed; detect the whole frame
+        DETECT,
+        // No tile has changed; the previous results are still valid
+        REUSE,
+        // Detect again only inside the changed regions
+        DETECT_REGIONS
+    };
+
+    enum {
+        // Tile side in quarter resolution pixels, 32 pixels at full resolution
+        TILE_SIZE = 8,
+        // Grayscale difference above which a pixel has changed
+        PIXEL_THRESHOLD = 24,
+        // Percentage of changed pixels for a tile to have changed
+        TILE_CHANGED_PERCENT = 5,
+        // Percentage of changed tiles above which the whole frame is
+        // detected again, as regions would cover most of it anyway
+        FULL_DETECT_PERCENT = 40
+    };
+
+    /**
+     * Compare a frame with the reference and decide how to detect on it.
+     *
+     * @param pyramid pyramid of the frame
+     * @return the detection to run on the frame
+     */
+    Action update(ImagePyramid &pyramid);
+
+    /**
+     * @return the changed regions of the last update in full resolution
+     *         pixels, which include a margin of one tile and do not overlap
+     */
+    const std::vector<cv::Rect> &regions() const;
+
+    /**
+     * Forget the reference so that the next frame is detected whole.
+     */
+    void reset();
+
+    /**
+     * Grow a region until it contains every box it intersects, so that
+     * results lying partly inside a changed region are detected again
+     * whole instead of being cut at its edge.
+     *
+     * @param region  region to grow
+     * @param boxes   bounding boxes of the current results
+     * @param covered set to whether each box is inside the grown region
+     * @return the grown region
+     */
+    static cv::Rect cover(cv::Rect region, const std::vector<cv::Rect> &boxes, std::vector<bool> &covered);
+
+private:
+    cv::UMat m_reference;
+    cv::UMat m_changed;
+    std::vector<cv::Rect> m_regions;
+};
+
+#endif //MINOTAUR_CPP_MOTIONGATE_H
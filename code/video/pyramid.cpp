@@ -0,0 +1,52 @@
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+
+#include "pyramid.h"
+
+ImagePyramid::ImagePyramid() {
+    release();
+}
+
+ImagePyramid::ImagePyramid(const cv::UMat &frame) {
+    reset(frame);
+}
+
+void ImagePyramid::reset(const cv::UMat &frame) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::fill(m_has_color, m_has_color + NUM_LEVELS, false);
+    std::fill(m_has_gray, m_has_gray + NUM_LEVELS, false);
+    m_color[FULL] = frame;
+    m_has_color[FULL] = !frame.empty();
+}
+
+void ImagePyramid::release() {
+    reset(cv::UMat());
+}
+
+const cv::UMat &ImagePyramid::color(Level level) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // Build each missing level from the one above it
+    for (int l = HALF; l <= level; ++l) {
+        if (m_has_color[l] || !m_has_color[l - 1]) { continue; }
+        cv::pyrDown(m_color[l - 1], m_color[l]);
+        m_has_color[l] = true;
+    }
+    return m_has_color[level] ? m_color[level] : m_empty;
+}
+
+const cv::UMat &ImagePyramid::gray(Level level) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_has_gray[FULL] && m_has_color[FULL]) {
+        cv::cvtColor(m_color[FULL], m_gray[FULL], cv::COLOR_BGR2GRAY);
+        m_has_gray[FULL] = true;
+    }
+    // Downsampling the single channel image is cheaper than
+    // converting a downsampled colour level
+    for (int l = HALF; l <= level; ++l) {
+        if (m_has_gray[l] || !m_has_gray[l - 1]) { continue; }
+        cv::pyrDown(m_gray[l - 1], m_gray[l]);
+        m_has_gray[l] = true;
+    }
+    return m_has_gray[level] ? m_gray[level] : m_empty;
+}
@@ -0,0 +1,72 @@
+#ifndef MINOTAUR_CPP_PYRAMID_H
+#define MINOTAUR_CPP_PYRAMID_H
+
+#include <opencv2/core/core.hpp>
+#include <mutex>
+
+/**
+ * Colour and grayscale image pyramid of a single frame, shared by the
+ * video modifiers so that downsampling and colour conversions are done
+ * at most once per frame. Thread-safe.
+ *
+ * Levels are built lazily on first request. Modifiers that draw on the
+ * frame must request the levels they need before drawing, and levels are
+ * only valid until the pyramid is reset with the next frame.
+ */
+class ImagePyramid {
+public:
+    enum Level {
+        FULL,
+        HALF,
+        QUARTER,
+        NUM_LEVELS
+    };
+
+    ImagePyramid();
+
+    /**
+     * Create a pyramid of a frame.
+     *
+     * @param frame full resolution BGR frame
+     */
+    explicit ImagePyramid(const cv::UMat &frame);
+
+    /**
+     * Start a new frame, invalidating all built levels. Level buffers
+     * are kept so that a frame of the same size does not allocate.
+     *
+     * @param frame full resolution BGR frame
+     */
+    void reset(const cv::UMat &frame);
+
+    /**
+     * Release the reference to the current frame. Level buffers are
+     * kept for the next frame.
+     */
+    void release();
+
+    /**
+     * @param level pyramid level
+     * @return the BGR frame at the level, empty if there is no frame
+     */
+    const cv::UMat &color(Level level);
+
+    /**
+     * @param level pyramid level
+     * @return the grayscale frame at the level, empty if there is no frame
+     */
+    const cv::UMat &gray(Level level);
+
+private:
+    // Guards lazy construction of the levels
+    std::mutex m_mutex;
+
+    cv::UMat m_color[NUM_LEVELS];
+    cv::UMat m_gray[NUM_LEVELS];
+    bool m_has_color[NUM_LEVELS];
+    bool m_has_gray[NUM_LEVELS];
+    // Returned for levels that cannot be built
+    const cv::UMat m_empty;
+};
+
+#endif //MINOTAUR_CPP_PYRAMID_H
@@ -0,0 +1,89 @@
+#include "searchwindow.h"
+
+#include <algorithm>
+
+// Weight given to the newest motion sample
+#define VELOCITY_SMOOTHING 0.5
+
+static cv::Point2d rect_center(const cv::Rect2d &box) {
+    return {box.x + box.width / 2, box.y + box.height / 2};
+}
+
+SearchWindow::SearchWindow() :
+    m_has_last(false),
+    m_scale(WINDOW_SCALE) {}
+
+void SearchWindow::reset() {
+    m_rect = cv::Rect();
+    m_velocity = cv::Point2d();
+    m_has_last = false;
+    m_scale = WINDOW_SCALE;
+}
+
+bool SearchWindow::follow(const cv::Rect2d &box, const cv::Size &frame) {
+    // Update the motion estimate
+    cv::Point2d center = rect_center(box);
+    if (m_has_last) {
+        m_velocity = VELOCITY_SMOOTHING * (center - m_last_center) +
+                     (1 - VELOCITY_SMOOTHING) * m_velocity;
+    }
+    m_last_center = center;
+    m_has_last = true;
+    // A window widened after a failure returns to its normal size
+    bool widened = m_scale != WINDOW_SCALE;
+    m_scale = WINDOW_SCALE;
+    // Keep a margin of half the target around the predicted box
+    cv::Rect2d next = predict(box);
+    cv::Rect2d interior(
+        m_rect.x + box.width / 2, m_rect.y + box.height / 2,
+        m_rect.width - box.width, m_rect.height - box.height
+    );
+    bool inside = m_rect.area() > 0 && (next & interior) == next;
+    if (!widened && inside) { return false; }
+    cv::Rect previous = m_rect;
+    center_on(next, frame);
+    return m_rect != previous;
+}
+
+void SearchWindow::widen(const cv::Rect2d &box, const cv::Size &frame) {
+    m_scale *= 2;
+    if (m_scale >= FULL_FRAME_SCALE) {
+        m_rect = cv::Rect(0, 0, frame.width, frame.height);
+        return;
+    }
+    center_on(predict(box), frame);
+}
+
+const cv::Rect &SearchWindow::rect() const {
+    return m_rect;
+}
+
+cv::Rect2d SearchWindow::to_local(const cv::Rect2d &box) const {
+    return {box.x - m_rect.x, box.y - m_rect.y, box.width, box.height};
+}
+
+cv::Rect2d SearchWindow::to_frame(const cv::Rect2d &box) const {
+    return {box.x + m_rect.x, box.y + m_rect.y, box.width, box.height};
+}
+
+cv::Rect2d SearchWindow::predict(const cv::Rect2d &box) const {
+    return {box.x + m_velocity.x, box.y + m_velocity.y, box.width, box.height};
+}
+
+void SearchWindow::set_velocity(const cv::Point2d &velocity) {
+    m_velocity = velocity;
+}
+
+void SearchWindow::center_on(const cv::Rect2d &box, const cv::Size &frame) {
+    int width = std::max(static_cast<int>(box.width * m_scale), static_cast<int>(MIN_WINDOW_SIZE));
+    int height = std::max(static_cast<int>(box.height * m_scale), static_cast<int>(MIN_WINDOW_SIZE));
+    width = std::min(width, frame.width);
+    height = std::min(height, frame.height);
+    cv::Point2d center = rect_center(box);
+    // Shift the window back inside the frame rather than shrinking it
+    int x = static_cast<int>(center.x) - width / 2;
+    int y = static_cast<int>(center.y) - height / 2;
+    x = std::max(0, std::min(x, frame.width - width));
+    y = std::max(0, std::min(y, frame.height - height));
+    m_rect = cv::Rect(x, y, width, height);
+}
@@ -0,0 +1,104 @@
+#ifndef MINOTAUR_CPP_SEARCHWINDOW_H
+#define MINOTAUR_CPP_SEARCHWINDOW_H
+
+#include <opencv2/core/core.hpp>
+
+/**
+ * Region of the frame in which a tracker searches for its target, so
+ * that trackers are not updated with the full frame.
+ *
+ * Trackers keep their state in the coordinates of the image they are
+ * given, so the window stays fixed while the target is well inside it.
+ * When the target, predicted forward by its recent motion, approaches
+ * the edge, the window is moved ahead of it and the tracker must be
+ * re-initialized in the new window. After a tracking failure the window
+ * is widened until it covers the full frame.
+ */
+class SearchWindow {
+public:
+    enum {
+        // Window dimensions as a multiple of the target dimensions
+        WINDOW_SCALE = 4,
+        // Minimum window dimension in pixels
+        MIN_WINDOW_SIZE = 96,
+        // Scale at which a widened window becomes the full frame
+        FULL_FRAME_SCALE = 32
+    };
+
+    SearchWindow();
+
+    /**
+     * Forget the target's motion and return to the normal window size.
+     */
+    void reset();
+
+    /**
+     * Follow a newly tracked target box. The window is moved if the
+     * target's predicted next position is close to the window edge, or
+     * if the window was widened after a failure.
+     *
+     * @param box   target box in frame coordinates
+     * @param frame frame dimensions
+     * @return whether the window moved and the tracker must be re-initialized
+     */
+    bool follow(const cv::Rect2d &box, const cv::Size &frame);
+
+    /**
+     * Widen the window around the target's predicted position after
+     * a tracking failure.
+     *
+     * @param box   last known target box in frame coordinates
+     * @param frame frame dimensions
+     */
+    void widen(const cv::Rect2d &box, const cv::Size &frame);
+
+    /**
+     * @return the window in frame coordinates
+     */
+    const cv::Rect &rect() const;
+
+    /**
+     * @param box box in frame coordinates
+     * @return the box in window coordinates
+     */
+    cv::Rect2d to_local(const cv::Rect2d &box) const;
+
+    /**
+     * @param box box in window coordinates
+     * @return the box in frame coordinates
+     */
+    cv::Rect2d to_frame(const cv::Rect2d &box) const;
+
+    /**
+     * @param box last known target box in frame coordinates
+     * @return the box moved by the target's recent motion
+     */
+    cv::Rect2d predict(const cv::Rect2d &box) const;
+
+    /**
+     * Replace the target's recent motion with an estimate from elsewhere,
+     * such as a filter of its pose.
+     *
+     * @param velocity target motion in pixels per frame
+     */
+    void set_velocity(const cv::Point2d &velocity);
+
+private:
+    /**
+     * Center the window on a box at the current scale.
+     *
+     * @param box   box in frame coordinates
+     * @param frame frame dimensions
+     */
+    void center_on(const cv::Rect2d &box, const cv::Size &frame);
+
+    cv::Rect m_rect;
+    // Smoothed target motion in pixels per frame
+    cv::Point2d m_velocity;
+    cv::Point2d m_last_center;
+    bool m_has_last;
+    // Current window scale, widened after failures
+    double m_scale;
+};
+
+#endif //MINOTAUR_CPP_SEARCHWINDOW_H
@@ -1,7 +1,13 @@
 #include <opencv2/imgproc.hpp>
 #include <opencv/cv.hpp>
+#include <limits>
 
 #include "shapedetect.h"
+#include "motiongate.h"
+#include "pyramid.h"
+#include "../camera/frame.h"
+#include "../compstate/compstate.h"
+#include "../gui/global.h"
 #include "../utility/logger.h"
 
 const int minTriangleArea = 10;
@@ -17,6 +23,52 @@ static double angle(cv::Point pt1, cv::Point pt2, cv::Point pt0) {
     return (dx1 * dx2 + dy1 * dy2) / sqrt((dx1 * dx1 + dy1 * dy1) * (dx2 * dx2 + dy2 * dy2) + 1e-10);
 }
 
+// Ratio of the smaller to the larger of two areas, 1 if they are equal
+static double area_match(double area, double ideal_area) {
+    area = std::fabs(area);
+    ideal_area = std::fabs(ideal_area);
+    if (area <= 0 || ideal_area <= 0) { return 0; }
+    return area < ideal_area ? area / ideal_area : ideal_area / area;
+}
+
+// How closely a convex polygon matches the regular polygon with as many
+// vertices, in [0, 1]: the ratio of its shortest to longest side, scaled
+// down by how far its worst corner is from the regular corner angle
+static double regularity(const std::vector<cv::Point> &polygon) {
+    std::size_t n = polygon.size();
+    if (n < 3) { return 0; }
+    double ideal_angle = CV_PI * (n - 2) / n;
+    double min_side = std::numeric_limits<double>::max();
+    double max_side = 0;
+    double max_error = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        const cv::Point &prev = polygon[i];
+        const cv::Point &corner = polygon[(i + 1) % n];
+        const cv::Point &next = polygon[(i + 2) % n];
+        double side = cv::norm(corner - prev);
+        min_side = std::min(min_side, side);
+        max_side = std::max(max_side, side);
+        double corner_angle = std::acos(std::max(-1.0, std::min(1.0, angle(prev, next, corner))));
+        max_error = std::max(max_error, std::fabs(corner_angle - ideal_angle));
+    }
+    if (max_side <= 0) { return 0; }
+    return min_side / max_side * std::max(0.0, 1 - max_error / ideal_angle);
+}
+
+// Label drawn over shapes of a CompetitionState object type
+static const char *shape_label(int type) {
+    switch (type) {
+        case CompetitionState::TRIANGLE:
+            return "TRI";
+        case CompetitionState::SQUARE:
+            return "RECT";
+        case CompetitionState::CIRCLE:
+            return "CIR";
+        default:
+            return "";
+    }
+}
+
 /*// Draws shapes (triangles and rectangles)
 static void drawShapes(cv::UMat &image, const std::vector<std::vector<cv::Point> > &squares) {
     for (const auto &square : squares) {
@@ -24,58 +76,31 @@ static void drawShapes(cv::UMat &image, const std::vector<std::vector<cv::Point>
     }
 }*/
 
-// Displays text in the center of a contour
-void setLabel(cv::UMat &im, const std::string &label, std::vector<cv::Point> &contour) {
-    constexpr int font_face = cv::FONT_HERSHEY_SIMPLEX;
-    constexpr double scale = 0.4;
-    constexpr int thickness = 1;
-    int baseline = 0;
-
-    cv::Size text = cv::getTextSize(label, font_face, scale, thickness, &baseline);
-    cv::Rect r = cv::boundingRect(contour);
-
-    cv::Point pt(r.x + ((r.width - text.width) / 2), r.y + ((r.height + text.height) / 2));
-    cv::rectangle(im, pt + cv::Point(0, baseline), pt + cv::Point(text.width, -text.height), cv::Scalar(255, 255, 255),
-                  cv::FILLED);
-    cv::putText(im, label, pt, font_face, scale, cv::Scalar(0, 0, 0), thickness, 8);
-}
-
-static cv::UMat findShapes(
-    const cv::UMat &src,
-    std::vector<std::vector<cv::Point> > &triangles,
-    std::vector<std::vector<cv::Point> > &rectangles,
-    std::vector<std::vector<cv::Point> > &circles
+static void findShapes(
+    const cv::UMat &denoised,
+    std::vector<std::vector<cv::Point> > &contours,
+    std::vector<ShapeDetect::Shape> &shapes,
+    cv::Point offset = cv::Point()
 ) {
-    triangles.clear();
-    rectangles.clear();
-    circles.clear();
+    contours.clear();
+    shapes.clear();
 
     /*
      * Process image to find contours.
      */
-    // Convert to grayscale
-    cv::UMat gray;
-    cv::cvtColor(src, gray, CV_BGR2GRAY);
-
     // Use Canny instead of threshold to catch squares with gradient shading
     cv::UMat bw;
 
-    //Removes noise from photo
-    cv::fastNlMeansDenoising(gray, bw, 35, 10,
-                             21);    //(input, output, filter strength, template window size, search window size)
-
     //Sharpen image
     // cv::Mat blur;
     // cv::GaussianBlur(gray, blur, cv::Size(0, 0), 3);	//(src, dst, , )
     // cv::addWeighted(bw, 0.7, blur, 0.3, 0, bw);	//(src1, weight1, src2, weight2, gamma, output)
 
-    //Canny edge detection
-    cv::Canny(bw, bw, 0, 50, 5);
+    //Canny edge detection on the frame denoised by the caller
+    cv::Canny(denoised, bw, 0, 50, 5);
 
     // Find contours
-    std::vector<std::vector<cv::Point> > contours;
-    cv::findContours(bw, contours, CV_RETR_EXTERNAL, CV_CHAIN_APPROX_SIMPLE);    //(image, output, mode, method)
-    cv::drawContours(src, contours, -1, cv::Scalar(255, 0, 0), 2, CV_AA);
+    cv::findContours(bw, contours, CV_RETR_EXTERNAL, CV_CHAIN_APPROX_SIMPLE, offset);    //(image, output, mode, method, offset)
 
     //Close contours
     // std::vector<cv::Point> ConvexHullPoints;
@@ -85,7 +110,6 @@ static cv::UMat findShapes(
     // drawShapes(drawing, ConvexHullPoints, "Contours Convex Hull");
 
     std::vector<cv::Point> approx;
-    cv::UMat dst(src);
 
     /*
      * Shape detection using contours.
@@ -101,8 +125,9 @@ static cv::UMat findShapes(
 
         if (approx.size() == 3 &&
             (std::fabs(cv::contourArea(contours[i])) > minTriangleArea && cv::isContourConvex(approx))) {
-            setLabel(dst, "TRI", contours[i]);    // Triangles
-            triangles.push_back(approx);
+            // Triangles
+            shapes.push_back({CompetitionState::TRIANGLE, i, regularity(approx) *
+                              area_match(cv::contourArea(contours[i]), cv::contourArea(approx))});
             //std::cout << "Triangle " << i << approx[0] << approx[1] << approx[2] << std::endl;
         } else if (approx.size() >= 4 && approx.size() <= 6) {
             // Number of vertices of polygonal curve
@@ -125,8 +150,8 @@ static cv::UMat findShapes(
             // to determine the shape of the contour
             if (vtc == 4 && min_cos >= -0.1 && max_cos <= 0.3 &&
                 (std::fabs(cv::contourArea(contours[i])) > min_square_area && cv::isContourConvex(approx))) {
-                setLabel(dst, "RECT", contours[i]);
-                rectangles.push_back(approx);
+                shapes.push_back({CompetitionState::SQUARE, i, regularity(approx) *
+                                  area_match(cv::contourArea(contours[i]), cv::contourArea(approx))});
 
                 //std::cout << "Rectangle " << i << approx[0] << approx[1] << approx[2] << approx[3] << std::endl;
 
@@ -147,24 +172,123 @@ static cv::UMat findShapes(
 
             if (std::abs(1 - ((double) r.width / r.height)) <= 0.2 &&
                 std::abs(1 - (area / (CV_PI * std::pow(radius, 2)))) <= 0.2) {
-                setLabel(dst, "CIR", contours[i]);
-                circles.push_back(approx);
+                double aspect = (double) std::min(r.width, r.height) / std::max(r.width, r.height);
+                shapes.push_back({CompetitionState::CIRCLE, i, aspect * area_match(area, CV_PI * std::pow(radius, 2))});
                 //circle(dst, approx.back(), radius, cvScalar(0,255,0), 3, cv::LINE_AA);
             }
 
         }
     }
-    return dst;
 }
 
-void ShapeDetect::modify(cv::UMat &img) {
-    std::vector<std::vector<cv::Point>> triangles;
-    std::vector<std::vector<cv::Point>> rectangles;
-    std::vector<std::vector<cv::Point>> circles;
+ShapeDetect::ShapeDetect(int denoise) :
+    m_denoiser(std::make_shared<Denoiser>(denoise)),
+    m_object_locked(false) {
+    // There is no competition state to feed without a main window
+    if (!Main::get()) { return; }
+    CompetitionState *state = &Main::get()->state();
+    m_object_locked = state->is_tracking_object();
+    connect(state, &CompetitionState::object_locked, this, &ShapeDetect::set_object_locked);
+}
+
+void ShapeDetect::set_object_locked(bool locked) {
+    m_object_locked = locked;
+}
 
-    img = findShapes(img, triangles, rectangles, circles);
-    // Outline rectangles and triangles in blue
-    //drawShapes(*img, triangles);
-    //drawShapes(*img, rectangles);
+void ShapeDetect::detect(const cv::UMat &, ImagePyramid &pyramid) {
+    if (m_object_locked) {
+        // The tracker follows the object; detect the whole frame again
+        // once it lets go, rather than trusting stale motion references
+        m_contours.clear();
+        m_shapes.clear();
+        reset_motion_gate();
+        return;
+    }
+    denoise(pyramid);
+    findShapes(m_denoised, m_contours, m_shapes);
+}
+
+void ShapeDetect::prepare(const cv::UMat &, ImagePyramid &pyramid) {
+    if (m_denoiser->method() == Denoiser::TEMPORAL) { m_denoiser->apply(pyramid.gray(ImagePyramid::FULL), m_denoised); }
+}
 
+void ShapeDetect::denoise(ImagePyramid &pyramid) {
+    if (m_denoiser->method() != Denoiser::TEMPORAL) { m_denoiser->apply(pyramid.gray(ImagePyramid::FULL), m_denoised); }
 }
+
+std::shared_ptr<VideoModifier> ShapeDetect::create() const {
+    auto detect = std::make_shared<ShapeDetect>(m_denoiser->method());
+    detect->m_denoiser = m_denoiser;
+    return detect;
+}
+
+void ShapeDetect::copy_results(const VideoModifier &from) {
+    const ShapeDetect &other = static_cast<const ShapeDetect &>(from);
+    m_contours = other.m_contours;
+    m_shapes = other.m_shapes;
+}
+
+bool ShapeDetect::motion_gated() const {
+    return true;
+}
+
+void ShapeDetect::detect_regions(const cv::UMat &img, ImagePyramid &pyramid, const std::vector<cv::Rect> &regions) {
+    if (m_object_locked) {
+        detect(img, pyramid);
+        return;
+    }
+    denoise(pyramid);
+    cv::Rect frame(cv::Point(), img.size());
+    std::vector<std::vector<cv::Point>> contours;
+    std::vector<Shape> shapes;
+    for (const cv::Rect &changed : regions) {
+        std::vector<cv::Rect> boxes;
+        for (const auto &contour : m_contours) { boxes.push_back(cv::boundingRect(contour)); }
+        std::vector<bool> covered;
+        cv::Rect region = MotionGate::cover(changed, boxes, covered) & frame;
+        // Keep the contours outside the region, and their shapes
+        std::vector<std::size_t> index(m_contours.size());
+        std::vector<std::vector<cv::Point>> kept;
+        for (std::size_t i = 0; i < m_contours.size(); ++i) {
+            if (covered[i]) { continue; }
+            index[i] = kept.size();
+            kept.push_back(std::move(m_contours[i]));
+        }
+        std::vector<Shape> kept_shapes;
+        for (const Shape &shape : m_shapes) {
+            if (!covered[shape.contour]) { kept_shapes.push_back({shape.type, index[shape.contour], shape.confidence}); }
+        }
+        // Find the shapes of the region again
+        findShapes(m_denoised(region), contours, shapes, region.tl());
+        for (const Shape &shape : shapes) {
+            kept_shapes.push_back({shape.type, kept.size() + shape.contour, shape.confidence});
+        }
+        kept.insert(kept.end(), contours.begin(), contours.end());
+        m_contours.swap(kept);
+        m_shapes.swap(kept_shapes);
+    }
+}
+
+void ShapeDetect::draw(cv::UMat &, annotation_list &annotations) {
+    std::vector<std::string> names(m_contours.size());
+    for (const Shape &shape : m_shapes) { names[shape.contour] = shape_label(shape.type); }
+    // Outline the contours in blue with their shape labels
+    for (std::size_t i = 0; i < m_contours.size(); ++i) {
+        annotations.emplace_back(m_contours[i], cv::Scalar(255, 0, 0), 2, names[i]);
+    }
+}
+
+void ShapeDetect::report(FrameMeta &meta) {
+    if (m_shapes.empty()) { return; }
+    detection_list &detections = meta.detected();
+    for (const Shape &shape : m_shapes) {
+        const std::vector<cv::Point> &contour = m_contours[shape.contour];
+        cv::Rect2d box = cv::boundingRect(contour);
+        cv::Moments moments = cv::moments(contour);
+        cv::Point2d centroid = moments.m00 != 0
+                               ? cv::Point2d(moments.m10 / moments.m00, moments.m01 / moments.m00)
+                               : (box.tl() + box.br()) * 0.5;
+        detections.push_back({shape.type, centroid, box, shape.confidence});
+    }
+}
+
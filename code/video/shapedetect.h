@@ -8,11 +8,90 @@
 #ifndef MINOTAUR_CPP_SHAPEDETECT_H
 #define MINOTAUR_CPP_SHAPEDETECT_H
 
+#include <atomic>
+#include <memory>
+
 #include "modify.h"
+#include "denoise.h"
 
 class ShapeDetect : public VideoModifier {
+Q_OBJECT
+
 public:
-    void modify(cv::UMat &img) override;
+    /**
+     * A labelled contour.
+     */
+    struct Shape {
+        // One of the CompetitionState object types
+        int type;
+        // Index of the contour
+        std::size_t contour;
+        // How closely the contour matches the ideal shape, in [0, 1]
+        double confidence;
+    };
+
+    /**
+     * @param denoise denoise method applied before edge detection
+     */
+    explicit ShapeDetect(int denoise = Denoiser::NON_LOCAL_MEANS);
+
+    void detect(const cv::UMat &img, ImagePyramid &pyramid) override;
+
+    void draw(cv::UMat &img, annotation_list &annotations) override;
+
+    /**
+     * Add the shapes found in the frame to its detections, which the
+     * preprocessor publishes to the CompetitionState.
+     *
+     * @param meta metadata of the frame
+     */
+    void report(FrameMeta &meta) override;
+
+    bool motion_gated() const override;
+
+    void detect_regions(const cv::UMat &img, ImagePyramid &pyramid, const std::vector<cv::Rect> &regions) override;
+
+    /**
+     * Stop detecting while the object is locked by a tracker, and start
+     * again once it is not.
+     *
+     * @param locked whether the object is locked
+     */
+    Q_SLOT void set_object_locked(bool locked);
+
+protected:
+    /**
+     * Clones share the denoiser, so that they add to the same temporal
+     * average.
+     */
+    std::shared_ptr<VideoModifier> create() const override;
+
+    void copy_results(const VideoModifier &from) override;
+
+    /**
+     * Add the frame to the temporal average, which must see every frame
+     * in order, including those that are not detected on.
+     */
+    void prepare(const cv::UMat &img, ImagePyramid &pyramid) override;
+
+private:
+    /**
+     * Denoise the frame with a spatial method. Those have no state, so
+     * clones run them concurrently with detection.
+     *
+     * @param pyramid pyramid of the frame
+     */
+    void denoise(ImagePyramid &pyramid);
+
+    // Contours found by the last detect()
+    std::vector<std::vector<cv::Point>> m_contours;
+    // Shapes among the contours
+    std::vector<Shape> m_shapes;
+    // Noise filter of the grayscale frame, and its last output
+    std::shared_ptr<Denoiser> m_denoiser;
+    cv::UMat m_denoised;
+    // Set from the thread of the CompetitionState
+    std::atomic<bool> m_object_locked;
 };
 
 
@@ -1,9 +1,10 @@
 #include "squares.h"
+#include "motiongate.h"
+#include "pyramid.h"
 
 #include <opencv2/opencv.hpp>
 
-int thresh = 0;
-int N = 50;
+#include <algorithm>
 
 using std::vector;
 using namespace cv;
@@ -16,89 +17,222 @@ static double angle(Point pt1, Point pt2, Point pt0) {
     return (dx1 * dx2 + dy1 * dy2) / sqrt((dx1 * dx1 + dy1 * dy1) * (dx2 * dx2 + dy2 * dy2) + 1e-10);
 }
 
-// returns sequence of squares detected on the image.
-// the sequence is stored in the specified memory storage
-static void findSquares(cv::UMat &image, vector<vector<Point> > &squares) {
-    squares.clear();
-
-    Mat pyr, timg, gray0(image.size(), CV_8U), gray;
-
-    // down-scale and upscale the image to filter out the noise
-    pyrDown(image, pyr, Size(image.cols / 2, image.rows / 2));
-    pyrUp(pyr, timg, image.size());
-    vector<vector<Point>> contours;
-
-    // find squares in every color plane of the image
-    for (int c = 0; c < 3; c++) {
-        int ch[] = {c, 0};
-        mixChannels(&timg, 1, &gray0, 1, ch, 1);
+// approximates a contour and tests whether it is a square
+static bool approxSquare(const vector<Point> &contour, vector<Point> &approx) {
+    // approximate contour with accuracy proportional
+    // to the contour perimeter
+    approxPolyDP(Mat(contour), approx, arcLength(Mat(contour), true) * 0.02, true);
+
+    // square contours should have 4 vertices after approximation
+    // relatively large area (to filter out noisy contours)
+    // and be convex.
+    // Note: absolute value of an area is used because
+    // area may be positive or negative - in accordance with the
+    // contour orientation
+    if (approx.size() != 4 ||
+        fabs(contourArea(Mat(approx))) <= Squares::MIN_AREA ||
+        !isContourConvex(Mat(approx))) {
+        return false;
+    }
+    double maxCosine = 0;
+    for (int j = 2; j < 5; j++) {
+        // find the maximum cosine of the angle between joint edges
+        double cosine = fabs(angle(approx[j % 4], approx[j - 2], approx[j - 1]));
+        maxCosine = MAX(maxCosine, cosine);
+    }
+    // if cosines of all angles are small
+    // (all angles are ~90 degree) then it is a square
+    return maxCosine < 0.3;
+}
 
-        // try several threshold levels
-        for (int l = 0; l < N; l++) {
+// Finds the squares of each colour plane and threshold level of the
+// sweep, each into its own list so that the merge is deterministic.
+// The planes and levels are independent and run in parallel
+class SquareSweep : public ParallelLoopBody {
+public:
+    SquareSweep(const vector<Mat> &planes, int levels, int canny_threshold, Point offset,
+                vector<vector<vector<Point>>> &found) :
+        m_planes(planes),
+        m_levels(levels),
+        m_canny_threshold(canny_threshold),
+        m_offset(offset),
+        m_found(found) {}
+
+    void operator()(const Range &range) const override {
+        // Buffers reused by the iterations run on this thread
+        Mat gray;
+        vector<vector<Point>> contours;
+        vector<Point> approx;
+        for (int i = range.start; i < range.end; ++i) {
+            const Mat &gray0 = m_planes[i / m_levels];
+            int l = i % m_levels;
             // hack: use Canny instead of zero threshold level.
             // Canny helps to catch squares with gradient shading
             if (l == 0) {
                 // apply Canny. Take the upper threshold from slider
                 // and set the lower to 0 (which forces edges merging)
-                Canny(gray0, gray, 0, thresh, 5);
+                Canny(gray0, gray, 0, m_canny_threshold, 5);
                 // dilate canny output to remove potential
                 // holes between edge segments
                 dilate(gray, gray, Mat(), Point(-1, -1));
             } else {
                 // apply threshold if l!=0:
-                //     tgray(x,y) = gray(x,y) < (l+1)*255/N ? 255 : 0
-                gray = gray0 >= (l + 1) * 255 / N;
+                //     tgray(x,y) = gray(x,y) < (l+1)*255/levels ? 255 : 0
+                threshold(gray0, gray, (l + 1) * 255 / m_levels - 1, 255, THRESH_BINARY);
             }
 
             // find contours and store them all as a list
-            findContours(gray, contours, RETR_LIST, CHAIN_APPROX_SIMPLE);
-
-            vector<Point> approx;
+            findContours(gray, contours, RETR_LIST, CHAIN_APPROX_SIMPLE, m_offset);
 
             // test each contour
             for (const auto &contour : contours) {
-                // approximate contour with accuracy proportional
-                // to the contour perimeter
-                approxPolyDP(Mat(contour), approx, arcLength(Mat(contour), true) * 0.02, true);
-
-                // square contours should have 4 vertices after approximation
-                // relatively large area (to filter out noisy contours)
-                // and be convex.
-                // Note: absolute value of an area is used because
-                // area may be positive or negative - in accordance with the
-                // contour orientation
-                if (approx.size() == 4 &&
-                    fabs(contourArea(Mat(approx))) > 1000 &&
-                    isContourConvex(Mat(approx))) {
-                    double maxCosine = 0;
-
-                    for (int j = 2; j < 5; j++) {
-                        // find the maximum cosine of the angle between joint edges
-                        double cosine = fabs(angle(approx[j % 4], approx[j - 2], approx[j - 1]));
-                        maxCosine = MAX(maxCosine, cosine);
-                    }
-
-                    // if cosines of all angles are small
-                    // (all angles are ~90 degree) then write quandrange
-                    // vertices to resultant sequence
-                    if (maxCosine < 0.3) {
-                        squares.push_back(approx);
-                    }
+                if (approxSquare(contour, approx)) { m_found[i].push_back(approx); }
+            }
+        }
+    }
+
+private:
+    const vector<Mat> &m_planes;
+    int m_levels;
+    int m_canny_threshold;
+    Point m_offset;
+    vector<vector<vector<Point>>> &m_found;
+};
+
+// Finds the squares of each colour plane from its component tree, the
+// nested connected regions of every threshold level, built in a single
+// pass over the plane. Only the outlines of stable regions are traced
+// and tested, instead of every contour of every level
+class SquareRegions : public ParallelLoopBody {
+public:
+    SquareRegions(const vector<Mat> &planes, int levels, Point offset, vector<vector<vector<Point>>> &found) :
+        m_planes(planes),
+        m_levels(levels),
+        m_offset(offset),
+        m_found(found) {}
+
+    void operator()(const Range &range) const override {
+        // Buffers reused by the planes run on this thread
+        vector<vector<Point>> regions;
+        vector<Rect> boxes;
+        Mat mask;
+        vector<vector<Point>> contours;
+        vector<Point> approx;
+        for (int i = range.start; i < range.end; ++i) {
+            const Mat &plane = m_planes[i];
+            // Regions must grow by a level to be compared for stability
+            int max_area = static_cast<int>(plane.total() * Squares::MAX_REGION_PERCENT / 100);
+            Ptr<MSER> tree = MSER::create(std::max(1, 255 / m_levels), Squares::MIN_AREA, max_area);
+            tree->detectRegions(plane, regions, boxes);
+            for (std::size_t r = 0; r < regions.size(); ++r) {
+                // Trace the outline of the region within its bounding box
+                mask.create(boxes[r].size(), CV_8U);
+                mask.setTo(Scalar::all(0));
+                for (const Point &p : regions[r]) { mask.at<uchar>(p - boxes[r].tl()) = 255; }
+                findContours(mask, contours, RETR_EXTERNAL, CHAIN_APPROX_SIMPLE, boxes[r].tl() + m_offset);
+                for (const auto &contour : contours) {
+                    if (approxSquare(contour, approx)) { m_found[i].push_back(approx); }
                 }
             }
         }
     }
+
+private:
+    const vector<Mat> &m_planes;
+    int m_levels;
+    Point m_offset;
+    vector<vector<vector<Point>>> &m_found;
+};
+
+// whether a square is the same as one already found, at another
+// level or as the other edge of the same outline
+static bool isDuplicate(const Rect &box, const vector<Rect> &found) {
+    for (const Rect &other : found) {
+        int overlap = (box & other).area();
+        int total = box.area() + other.area() - overlap;
+        if (overlap * 100 > total * Squares::DUPLICATE_OVERLAP_PERCENT) { return true; }
+    }
+    return false;
+}
+
+// returns sequence of squares detected on the image, given its
+// half resolution level. offset is added to the square vertices
+static void findSquares(const UMat &image, const UMat &half, vector<vector<Point> > &squares,
+                        int method, int levels, Point offset = Point()) {
+    squares.clear();
+
+    // upscale the half level to filter out the noise
+    Mat timg;
+    pyrUp(half, timg, image.size());
+
+    // find squares in every color plane of the image,
+    // trying several threshold levels
+    vector<Mat> planes;
+    split(timg, planes);
+    vector<vector<vector<Point>>> found;
+    if (method == Squares::THRESHOLD_SWEEP) {
+        found.resize(planes.size() * levels);
+        parallel_for_(Range(0, static_cast<int>(found.size())),
+                      SquareSweep(planes, levels, Squares::CANNY_THRESHOLD, offset, found));
+    } else {
+        found.resize(planes.size());
+        parallel_for_(Range(0, static_cast<int>(found.size())), SquareRegions(planes, levels, offset, found));
+    }
+
+    // merge in plane and level order, keeping the first of each duplicate
+    vector<Rect> boxes;
+    for (const auto &level : found) {
+        for (const auto &square : level) {
+            Rect box = boundingRect(square);
+            if (isDuplicate(box, boxes)) { continue; }
+            boxes.push_back(box);
+            squares.push_back(square);
+        }
+    }
 }
 
-// the function draws all the squares in the image
-static void drawSquares(cv::UMat &image, const vector<vector<Point>> &squares) {
-    for (const auto &square : squares) {
-        polylines(image, cv::InputArrayOfArrays(square), true, Scalar(0, 255, 0), 3);
+Squares::Squares(int method, int levels) :
+    m_method(method),
+    m_levels(std::max(1, std::min(levels, static_cast<int>(MAX_LEVELS)))) {}
+
+void Squares::detect(const cv::UMat &, ImagePyramid &pyramid) {
+    findSquares(pyramid.color(ImagePyramid::FULL), pyramid.color(ImagePyramid::HALF), m_squares, m_method, m_levels);
+}
+
+bool Squares::motion_gated() const {
+    return true;
+}
+
+void Squares::detect_regions(const cv::UMat &img, ImagePyramid &, const std::vector<cv::Rect> &regions) {
+    Rect frame(Point(), img.size());
+    for (const Rect &changed : regions) {
+        vector<Rect> boxes;
+        for (const auto &square : m_squares) { boxes.push_back(boundingRect(square)); }
+        vector<bool> covered;
+        Rect region = MotionGate::cover(changed, boxes, covered) & frame;
+        // Keep the squares outside the region and find its squares again
+        vector<vector<Point>> squares;
+        for (std::size_t i = 0; i < m_squares.size(); ++i) {
+            if (!covered[i]) { squares.push_back(std::move(m_squares[i])); }
+        }
+        UMat half;
+        pyrDown(img(region), half);
+        findSquares(img(region), half, m_squares, m_method, m_levels, region.tl());
+        squares.insert(squares.end(), m_squares.begin(), m_squares.end());
+        m_squares.swap(squares);
     }
 }
 
-void Squares::modify(cv::UMat &img) {
-    vector<vector<Point>> squares;
-    findSquares(img, squares);
-    drawSquares(img, squares);
-}
\ No newline at end of file
+std::shared_ptr<VideoModifier> Squares::create() const {
+    return std::make_shared<Squares>(m_method, m_levels);
+}
+
+void Squares::copy_results(const VideoModifier &from) {
+    m_squares = static_cast<const Squares &>(from).m_squares;
+}
+
+void Squares::draw(cv::UMat &, annotation_list &annotations) {
+    for (const auto &square : m_squares) {
+        annotations.emplace_back(square, Scalar(0, 255, 0), 3);
+    }
+}
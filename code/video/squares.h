@@ -3,10 +3,64 @@
 
 #include "modify.h"
 
+/**
+ * Finds squares among the regions of each colour plane of the frame at
+ * many threshold levels. The regions are extracted from a component tree
+ * of the plane or, as before, by thresholding and tracing contours at
+ * each level. Planes are searched in parallel, and squares found at
+ * several levels are reported once.
+ */
 class Squares : public VideoModifier {
 public:
-    void modify(cv::UMat &img) override;
+    enum Method {
+        // Outlines of the stable regions of a component tree, built in
+        // one pass over each plane
+        COMPONENT_TREE,
+        // Contours traced at each threshold level
+        THRESHOLD_SWEEP
+    };
+
+    enum {
+        // Threshold levels swept in each colour plane
+        DEFAULT_LEVELS = 50,
+        MAX_LEVELS = 255,
+        // Upper Canny threshold of the first sweep level
+        CANNY_THRESHOLD = 0,
+        // Area a square must exceed, in pixels
+        MIN_AREA = 1000,
+        // Largest component tree region, in percent of the plane, which
+        // keeps the background out of the candidates
+        MAX_REGION_PERCENT = 50,
+        // Squares whose bounding boxes overlap by more than this
+        // percentage of their union are the same square
+        DUPLICATE_OVERLAP_PERCENT = 80
+    };
+
+    /**
+     * @param method one of the extraction methods
+     * @param levels threshold levels in each colour plane
+     */
+    explicit Squares(int method = COMPONENT_TREE, int levels = DEFAULT_LEVELS);
+
+    void detect(const cv::UMat &img, ImagePyramid &pyramid) override;
+
+    void draw(cv::UMat &img, annotation_list &annotations) override;
+
+    bool motion_gated() const override;
+
+    void detect_regions(const cv::UMat &img, ImagePyramid &pyramid, const std::vector<cv::Rect> &regions) override;
+
+protected:
+    std::shared_ptr<VideoModifier> create() const override;
+
+    void copy_results(const VideoModifier &from) override;
+
+private:
+    // Squares found by the last detect()
+    std::vector<std::vector<cv::Point>> m_squares;
+    int m_method;
+    int m_levels;
 };
 
 
-#endif
\ No newline at end of file
+#endif
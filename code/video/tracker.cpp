@@ -6,6 +6,7 @@
 
 #include "tracker.h"
 #include "../camera/actionbutton.h"
+#include "../camera/framegraph.h"
 #include "../compstate/compstate.h"
 #include "../gui/global.h"
 
@@ -26,6 +27,10 @@
 
 __tracker::__tracker() :
     m_bounding_box(),
+    m_seeded(false),
+    m_has_velocity(false),
+    m_seen_time(0),
+    m_update_time(0),
     m_type(TRACKER_TYPE),
     m_state(State::UNINITIALIZED) {
     reset_tracker();
@@ -33,6 +38,11 @@ __tracker::__tracker() :
 
 void __tracker::reset_tracker() {
     m_mutex.lock();
+    create_tracker();
+    m_mutex.unlock();
+}
+
+void __tracker::create_tracker() {
     // At this point MIL seems to be the best performing tracker
     // Accuracy is more important than performance so long as
     // framerate remains above at least 12
@@ -61,53 +71,135 @@ void __tracker::reset_tracker() {
         default:
             break;
     }
-    m_mutex.unlock();
+}
+
+bool __tracker::init_in_window(const cv::UMat &img) {
+    cv::UMat window = img(m_window.rect());
+    return m_tracker->init(window, m_window.to_local(m_bounding_box));
 }
 
 void __tracker::begin_tracking() {
     if (m_state == State::UNINITIALIZED) {
+        m_mutex.lock();
         m_state = State::FIRST_SCAN;
+        bool seeded = m_seeded;
+        m_mutex.unlock();
+        if (!seeded) { Q_EMIT roi_requested(); }
     }
 }
 
 void __tracker::stop_tracking() {
     if (m_state != State::UNINITIALIZED) {
-        reset_tracker();
+        // The frame graph may be updating the tracker on another thread
+        m_mutex.lock();
+        create_tracker();
         m_state = State::UNINITIALIZED;
         m_bounding_box = {};
+        m_window.reset();
+        m_seeded = false;
+        m_has_velocity = false;
+        m_mutex.unlock();
+        Q_EMIT tracking(false);
     }
 }
 
-void __tracker::update_track(cv::UMat &img) {
+void __tracker::seed(const cv::Rect2d &box) {
+    m_mutex.lock();
+    m_seed = box;
+    m_seeded = true;
+    m_mutex.unlock();
+}
+
+void __tracker::set_target_velocity(double vx, double vy) {
+    m_mutex.lock();
+    m_target_velocity = cv::Point2d(vx, vy);
+    m_has_velocity = true;
+    m_mutex.unlock();
+}
+
+void __tracker::update_track(const cv::UMat &img, std::int64_t now) {
+    std::int64_t frame_interval = m_update_time > 0 ? now - m_update_time : 0;
+    m_update_time = now;
     if (m_state == State::FAILED) {
-        reset_tracker();
-        if (m_tracker->init(img, m_bounding_box)) {
+        m_mutex.lock();
+        if (m_state != State::FAILED) {
+            // Stopped since the check
+            m_mutex.unlock();
+            return;
+        }
+        create_tracker();
+        if (m_has_velocity) {
+            // Search where the filtered motion has taken the target since
+            // it was last seen, moving on with it each frame
+            cv::Point2d moved = m_target_velocity * ((now - m_seen_time) * 1e-9);
+            cv::Rect2d predicted = cv::Rect2d(m_seen_box.tl() + moved, m_seen_box.size()) &
+                                   cv::Rect2d(cv::Point2d(), cv::Size2d(img.size()));
+            if (predicted.area() > 0) { m_bounding_box = predicted; }
+            m_window.set_velocity(m_target_velocity * (frame_interval * 1e-9));
+        }
+        // Search a wider area on each consecutive failure,
+        // up to the full frame
+        m_window.widen(m_bounding_box, img.size());
+        if (init_in_window(img)) {
             m_state = State::TRACKING;
         }
+        m_mutex.unlock();
         return;
     }
     if (m_state != State::UNINITIALIZED) {
         m_mutex.lock();
         if (m_state == State::TRACKING) {
-            if (!m_tracker->update(img, m_bounding_box)) {
+            // Update the tracker with the search window only
+            cv::UMat window = img(m_window.rect());
+            cv::Rect2d local = m_window.to_local(m_bounding_box);
+            if (!m_tracker->update(window, local)) {
                 m_state = State::FAILED;
+            } else {
+                m_bounding_box = m_window.to_frame(local);
+                m_seen_box = m_bounding_box;
+                m_seen_time = now;
+                // Move the window ahead of the target before it reaches
+                // the edge; the tracker restarts in the new window
+                if (m_window.follow(m_bounding_box, img.size())) {
+                    create_tracker();
+                    if (!init_in_window(img)) { m_state = State::FAILED; }
+                }
             }
-        } else if (m_state == State::FIRST_SCAN) {
-            m_bounding_box = cv::selectROI(img);
-            if (m_tracker->init(img, m_bounding_box)) {
-                m_state = State::TRACKING;
+        } else if (m_state == State::FIRST_SCAN && m_seeded) {
+            // Until a target is detected or selected, frames pass
+            // through untracked rather than waiting for it
+            m_bounding_box = m_seed & cv::Rect2d(cv::Point2d(), cv::Size2d(img.size()));
+            m_seeded = false;
+            if (m_bounding_box.area() <= 0) {
+                // Selected outside the frame; ask again
+                Q_EMIT roi_requested();
             } else {
-                m_state = State::FAILED;
+                m_seen_box = m_bounding_box;
+                m_seen_time = now;
+                m_window.reset();
+                m_window.follow(m_bounding_box, img.size());
+                if (init_in_window(img)) {
+                    m_state = State::TRACKING;
+                } else {
+                    m_state = State::FAILED;
+                }
+                // A failed tracker keeps searching near the target
+                Q_EMIT tracking(true);
             }
         }
         m_mutex.unlock();
-        Q_EMIT target_box(m_bounding_box);
     }
 }
 
-void __tracker::draw_bounding_box(cv::UMat &img) {
+void __tracker::publish() {
     if (m_state == State::TRACKING) {
-        cv::rectangle(img, m_bounding_box.tl(), m_bounding_box.br(), cv::Scalar(255, 0, 0));
+        Q_EMIT target_box(m_bounding_box, m_update_time);
+    }
+}
+
+void __tracker::annotate(annotation_list &annotations) {
+    if (m_state == State::TRACKING) {
+        annotations.push_back(Annotation::rect(m_bounding_box, cv::Scalar(255, 0, 0)));
     }
 }
 
@@ -118,9 +210,27 @@ __tracker::State __tracker::state() const {
 TrackerModifier::TrackerModifier() :
     m_robot_tracker(),
     m_object_tracker() {
+    // There is no competition state to feed without a main window
+    if (!Main::get()) { return; }
     CompetitionState *state = &Main::get()->state();
     connect(&m_robot_tracker, &__tracker::target_box, state, &CompetitionState::acquire_robot_box);
     connect(&m_object_tracker, &__tracker::target_box, state, &CompetitionState::acquire_object_box);
+    // Failed trackers search where the filtered pose predicts the target
+    connect(state, &CompetitionState::robot_velocity, &m_robot_tracker, &__tracker::set_target_velocity);
+    connect(state, &CompetitionState::object_velocity, &m_object_tracker, &__tracker::set_target_velocity);
+    connect(&m_robot_tracker, &__tracker::tracking, state, &CompetitionState::set_tracking_robot);
+    connect(&m_object_tracker, &__tracker::tracking, state, &CompetitionState::set_tracking_object);
+    // Trackers are seeded from regions selected on the display, and the
+    // object also from shapes detected before it is tracked
+    connect(&m_robot_tracker, &__tracker::roi_requested, state, [state]() {
+        state->request_roi(CompetitionState::ROBOT_ROI);
+    });
+    connect(&m_object_tracker, &__tracker::roi_requested, state, [state]() {
+        state->request_roi(CompetitionState::OBJECT_ROI);
+    });
+    connect(state, &CompetitionState::robot_roi_selected, &m_robot_tracker, &__tracker::seed);
+    connect(state, &CompetitionState::object_roi_selected, &m_object_tracker, &__tracker::seed);
+    connect(state, &CompetitionState::object_detected, &m_object_tracker, &__tracker::seed);
 }
 
 void TrackerModifier::traverse() {
@@ -156,11 +266,38 @@ void TrackerModifier::register_actions(ActionBox *box) {
     box->set_actions();
 }
 
-void TrackerModifier::modify(cv::UMat &img) {
-    m_robot_tracker.update_track(img);
-    m_object_tracker.update_track(img);
-    m_robot_tracker.draw_bounding_box(img);
-    m_object_tracker.draw_bounding_box(img);
+void TrackerModifier::detect(const cv::UMat &img, ImagePyramid &) {
+    // Tracked at the time the frame was captured, as on the graph
+    m_robot_tracker.update_track(img, capture_time());
+    m_object_tracker.update_track(img, capture_time());
+}
+
+std::size_t TrackerModifier::add_nodes(FrameGraph &graph, const std::vector<std::size_t> &inputs) {
+    // Tracking takes as long as the slower tracker rather than both
+    std::vector<std::size_t> branches = add_detect_nodes(graph, inputs);
+    return graph.add_node("draw", [this](FrameContext &context) {
+        draw(context.frame.image, context.frame.meta.annotate());
+        report(context.frame.meta);
+    }, branches);
+}
+
+std::vector<std::size_t> TrackerModifier::add_detect_nodes(FrameGraph &graph, const std::vector<std::size_t> &inputs) {
+    return {
+        graph.add_node("track_robot", [this](FrameContext &context) {
+            m_robot_tracker.update_track(context.frame.image, context.frame.meta.capture_time);
+        }, inputs),
+        graph.add_node("track_object", [this](FrameContext &context) {
+            m_object_tracker.update_track(context.frame.image, context.frame.meta.capture_time);
+        }, inputs)
+    };
+}
+
+void TrackerModifier::draw(cv::UMat &, annotation_list &annotations) {
+    // Boxes reach the CompetitionState once all detection has finished
+    m_robot_tracker.publish();
+    m_object_tracker.publish();
+    m_robot_tracker.annotate(annotations);
+    m_object_tracker.annotate(annotations);
 }
 
 #endif
\ No newline at end of file
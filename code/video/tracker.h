@@ -3,9 +3,11 @@
 #ifndef TRACKER_OFF
 
 #include "modify.h"
+#include "searchwindow.h"
 #include "../compstate/procedure.h"
 #include <opencv2/tracking.hpp>
 #include <QMutex>
+#include <cstdint>
 
 class QVBoxLayout;
 class QPushButton;
@@ -32,13 +34,65 @@ public:
 
     __tracker();
 
-    void update_track(cv::UMat &img);
+    /**
+     * Track the target in a frame.
+     *
+     * @param img  full frame
+     * @param time monotonic time at which the frame was captured
+     */
+    void update_track(const cv::UMat &img, std::int64_t time);
 
-    void draw_bounding_box(cv::UMat &img);
+    /**
+     * Emit the bounding box found by the last update, if tracking.
+     */
+    void publish();
+
+    /**
+     * Add the bounding box to the frame annotations, if tracking.
+     *
+     * @param annotations annotations drawn over the frame
+     */
+    void annotate(annotation_list &annotations);
 
     State state() const;
 
-    Q_SIGNAL void target_box(const cv::Rect2d &box);
+    /**
+     * Signal emitted by publish() with the tracked bounding box.
+     *
+     * @param box          target bounding box in frame coordinates
+     * @param capture_time monotonic time at which its frame was captured
+     */
+    Q_SIGNAL void target_box(const cv::Rect2d &box, qint64 capture_time);
+
+    /**
+     * Signal emitted when the tracker locks onto its target, after the
+     * first scan, and when it is stopped.
+     */
+    Q_SIGNAL void tracking(bool tracking);
+
+    /**
+     * Signal emitted when tracking begins without a seed, to ask for a
+     * region of interest to be selected. Frames keep flowing while the
+     * first scan waits for it.
+     */
+    Q_SIGNAL void roi_requested();
+
+    /**
+     * Offer a bounding box found by a detector or selected on the
+     * display, which the first scan starts tracking from.
+     *
+     * @param box target bounding box in frame coordinates
+     */
+    Q_SLOT void seed(const cv::Rect2d &box);
+
+    /**
+     * Set the filtered velocity of the target, from which its position
+     * is predicted after a tracking failure.
+     *
+     * @param vx velocity along x in frame pixels per second
+     * @param vy velocity along y in frame pixels per second
+     */
+    Q_SLOT void set_target_velocity(double vx, double vy);
 
     Q_SLOT void begin_tracking();
 
@@ -47,9 +101,47 @@ public:
 private:
     void reset_tracker();
 
+    /**
+     * Create a new tracker instance. Must be called with the mutex held.
+     */
+    void create_tracker();
+
+    /**
+     * Initialize the tracker on the search window region of the image
+     * with the current bounding box.
+     *
+     * @param img full frame
+     * @return whether the tracker was initialized
+     */
+    bool init_in_window(const cv::UMat &img);
+
 private:
     cv::Ptr<cv::Tracker> m_tracker;
+    /**
+     * Target bounding box in frame coordinates.
+     */
     cv::Rect2d m_bounding_box;
+    /**
+     * Region of the frame passed to the tracker.
+     */
+    SearchWindow m_window;
+    /**
+     * Detected bounding box for the next first scan, if seeded.
+     */
+    cv::Rect2d m_seed;
+    bool m_seeded;
+    /**
+     * Filtered target velocity in frame pixels per second, if known.
+     */
+    cv::Point2d m_target_velocity;
+    bool m_has_velocity;
+    /**
+     * Last tracked bounding box, and the capture times of its frame and
+     * of the last frame updated.
+     */
+    cv::Rect2d m_seen_box;
+    std::int64_t m_seen_time;
+    std::int64_t m_update_time;
 
     Type m_type;
     State m_state;
@@ -71,7 +163,21 @@ Q_OBJECT
 public:
     TrackerModifier();
 
-    void modify(cv::UMat &img) override;
+    void detect(const cv::UMat &img, ImagePyramid &pyramid) override;
+
+    void draw(cv::UMat &img, annotation_list &annotations) override;
+
+    /**
+     * Update the robot and object trackers on branches of their own,
+     * joined before the boxes are drawn and published.
+     */
+    std::size_t add_nodes(FrameGraph &graph, const std::vector<std::size_t> &inputs) override;
+
+    /**
+     * The robot and object trackers are independent, so each updates
+     * on its own branch.
+     */
+    std::vector<std::size_t> add_detect_nodes(FrameGraph &graph, const std::vector<std::size_t> &inputs) override;
 
     void register_actions(ActionBox *box) override;
 
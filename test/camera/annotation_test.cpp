@@ -0,0 +1,30 @@
+#include <gtest/gtest.h>
+
+#include <code/camera/annotation.h>
+#include <code/camera/transform.h>
+
+TEST(annotation, rect_outline) {
+    Annotation box = Annotation::rect(cv::Rect2d(10, 20, 30, 40), cv::Scalar(255, 0, 0));
+    std::vector<cv::Point> expected{{10, 20}, {40, 20}, {40, 60}, {10, 60}};
+    ASSERT_EQ(expected, box.outline);
+    ASSERT_TRUE(box.label.empty());
+}
+
+TEST(annotation, draws_outline) {
+    cv::Mat image(64, 64, CV_8UC3, cv::Scalar(0, 0, 0));
+    annotation_list annotations{Annotation::rect(cv::Rect2d(8, 8, 32, 32), cv::Scalar(0, 255, 0))};
+    draw_annotations(image, annotations);
+    ASSERT_EQ(cv::Vec3b(0, 255, 0), image.at<cv::Vec3b>(8, 20));
+    // The outline is not filled
+    ASSERT_EQ(cv::Vec3b(0, 0, 0), image.at<cv::Vec3b>(20, 20));
+}
+
+TEST(annotation, follows_transform) {
+    std::vector<cv::Point> points{{40, 20}, {20, 20}};
+    FrameTransform::map(points, cv::Size(40, 40), 0.0, 1.0);
+    ASSERT_EQ(cv::Point(40, 20), points[0]);
+    // Zooming by two about the center doubles distances from it
+    FrameTransform::map(points, cv::Size(40, 40), 0.0, 2.0);
+    ASSERT_EQ(cv::Point(60, 20), points[0]);
+    ASSERT_EQ(cv::Point(20, 20), points[1]);
+}
@@ -0,0 +1,45 @@
+#include <gtest/gtest.h>
+
+#include <code/camera/framegraph.h>
+#include <code/utility/threadpool.h>
+#include <code/video/pyramid.h>
+
+#include <atomic>
+#include <stdexcept>
+
+TEST(frame_graph, runs_inputs_first) {
+    thread_pool pool(2);
+    FrameGraph graph(pool);
+    std::atomic<int> branches(0);
+    int joined = -1;
+    FrameGraph::node_id root = graph.add_node("root", [](FrameContext &) {});
+    FrameGraph::node_id left = graph.add_node("left", [&branches](FrameContext &) { ++branches; }, {root});
+    FrameGraph::node_id right = graph.add_node("right", [&branches](FrameContext &) { ++branches; }, {root});
+    graph.add_node("join", [&](FrameContext &) { joined = branches.load(); }, {left, right});
+    ASSERT_EQ(4, graph.size());
+
+    Frame frame;
+    ImagePyramid pyramid;
+    FrameContext context{frame, pyramid};
+    for (int i = 0; i < 50; ++i) {
+        branches = 0;
+        graph.run(context);
+        ASSERT_EQ(2, joined);
+    }
+}
+
+TEST(frame_graph, rethrows_after_join) {
+    thread_pool pool(1);
+    FrameGraph graph(pool);
+    bool ran = false;
+    FrameGraph::node_id fails = graph.add_node("fails", [](FrameContext &) {
+        throw std::runtime_error("node failed");
+    });
+    graph.add_node("after", [&ran](FrameContext &) { ran = true; }, {fails});
+
+    Frame frame;
+    ImagePyramid pyramid;
+    FrameContext context{frame, pyramid};
+    ASSERT_THROW(graph.run(context), std::runtime_error);
+    ASSERT_TRUE(ran);
+}
@@ -0,0 +1,74 @@
+#include <gtest/gtest.h>
+
+#include <code/camera/framepool.h>
+
+TEST(frame_pool, reuses_released_buffer) {
+    FramePool pool;
+    cv::UMat first = pool.acquire(cv::Size(64, 48), CV_8UC3);
+    cv::UMatData *data = first.u;
+    first.release();
+    cv::UMat second = pool.acquire(cv::Size(64, 48), CV_8UC3);
+    ASSERT_EQ(data, second.u);
+    ASSERT_EQ(1, pool.allocations());
+    ASSERT_EQ(1, pool.size());
+}
+
+TEST(frame_pool, does_not_share_held_buffer) {
+    FramePool pool;
+    cv::UMat first = pool.acquire(cv::Size(64, 48), CV_8UC3);
+    cv::UMat second = pool.acquire(cv::Size(64, 48), CV_8UC3);
+    ASSERT_NE(first.u, second.u);
+    ASSERT_EQ(2, pool.allocations());
+    // Buffers past the maximum are handed out but not pooled
+    FramePool small(1);
+    cv::UMat a = small.acquire(cv::Size(64, 48), CV_8UC3);
+    cv::UMat b = small.acquire(cv::Size(64, 48), CV_8UC3);
+    ASSERT_EQ(2, small.allocations());
+    ASSERT_EQ(1, small.size());
+}
+
+TEST(frame_pool, allocates_on_size_change) {
+    FramePool pool;
+    pool.acquire(cv::Size(64, 48), CV_8UC3);
+    cv::UMat resized = pool.acquire(cv::Size(32, 32), CV_8UC3);
+    ASSERT_EQ(cv::Size(32, 32), resized.size());
+    pool.acquire(cv::Size(32, 32), CV_8UC1);
+    ASSERT_EQ(3, pool.allocations());
+    // Only buffers not in use are cleared
+    pool.clear();
+    ASSERT_EQ(1, pool.size());
+    resized.release();
+    pool.clear();
+    ASSERT_EQ(0, pool.size());
+}
+
+TEST(frame_pool, pinned_buffer_is_not_reused) {
+    FramePool pool;
+    cv::UMat buffer = pool.acquire(cv::Size(64, 48), CV_8UC3);
+    cv::UMatData *data = buffer.u;
+    cv::Mat pixels;
+    void *handle = pool.pin(buffer, pixels);
+    ASSERT_NE(nullptr, handle);
+    ASSERT_FALSE(pixels.empty());
+    buffer.release();
+    pixels.release();
+    ASSERT_NE(data, pool.acquire(cv::Size(64, 48), CV_8UC3).u);
+    FramePool::unpin(handle);
+    ASSERT_EQ(data, pool.acquire(cv::Size(64, 48), CV_8UC3).u);
+}
+
+TEST(frame_pool, pin_outlives_pool) {
+    cv::Mat pixels;
+    void *handle;
+    {
+        FramePool pool;
+        cv::UMat buffer = pool.acquire(cv::Size(64, 48), CV_8UC1);
+        buffer.setTo(cv::Scalar(7));
+        handle = pool.pin(buffer, pixels);
+        ASSERT_NE(nullptr, handle);
+    }
+    // The mapping stays valid after the pool, and is released by unpin
+    ASSERT_EQ(7, pixels.at<uchar>(10, 10));
+    pixels.release();
+    FramePool::unpin(handle);
+}
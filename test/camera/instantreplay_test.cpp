@@ -0,0 +1,47 @@
+#include <gtest/gtest.h>
+
+#include <code/camera/instantreplay.h>
+#include <code/camera/session.h>
+
+#include <QTemporaryDir>
+
+static Frame numbered_frame(int n) {
+    Frame frame;
+    cv::Mat(48, 64, CV_8UC3, cv::Scalar(n, n, n)).copyTo(frame.image);
+    frame.meta.sequence = static_cast<std::uint64_t>(n);
+    // 10 frames per second
+    frame.meta.capture_time = 100000000LL * n;
+    return frame;
+}
+
+TEST(instant_replay, keeps_frames_within_budget) {
+    // One megabyte holds 113 frames of 64 by 48 pixels
+    InstantReplay replay(1, 60);
+    for (int i = 0; i < 200; ++i) { replay.frame_received(numbered_frame(i)); }
+    ASSERT_EQ(113, replay.size());
+    ASSERT_EQ(0, replay.missed());
+}
+
+TEST(instant_replay, dumps_last_seconds) {
+    QTemporaryDir dir;
+    QString file = dir.filePath("dump.session");
+    InstantReplay replay(1, 2);
+    for (int i = 0; i < 50; ++i) { replay.frame_received(numbered_frame(i)); }
+    replay.dump(file);
+
+    // Frames 29 to 49 are within two seconds of the newest
+    SessionReader reader;
+    ASSERT_TRUE(reader.open(file));
+    ASSERT_EQ(21, reader.size());
+    cv::Mat image;
+    FrameMeta meta;
+    ASSERT_TRUE(reader.read(0, image, meta));
+    ASSERT_EQ(29, meta.sequence);
+    ASSERT_EQ(29, image.at<cv::Vec3b>(0, 0)[0]);
+    ASSERT_TRUE(reader.read(20, image, meta));
+    ASSERT_EQ(49, meta.sequence);
+    // Older frames stay buffered and dumped buffers are reused
+    ASSERT_EQ(29, replay.size());
+    for (int i = 50; i < 60; ++i) { replay.frame_received(numbered_frame(i)); }
+    ASSERT_EQ(39, replay.size());
+}
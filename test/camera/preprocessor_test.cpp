@@ -0,0 +1,78 @@
+#include <gtest/gtest.h>
+
+#include <code/camera/preprocessor.h>
+#include <code/video/shapedetect.h>
+#include <code/video/squares.h>
+
+#include <opencv2/imgproc.hpp>
+
+#include <functional>
+#include <thread>
+
+// Two squares, one still and one that moves every few frames, with a
+// change of lighting halfway, so that a gated modifier reuses its
+// results, detects changed regions and detects whole frames
+static std::vector<Frame> moving_square(int count) {
+    std::vector<Frame> frames(count);
+    for (int i = 0; i < count; ++i) {
+        int background = i < count / 2 ? 0 : 40;
+        frames[i].image = cv::UMat(cv::Size(320, 240), CV_8UC3, cv::Scalar::all(background));
+        cv::rectangle(frames[i].image, cv::Rect(30, 40, 60, 60), cv::Scalar(255, 255, 255), cv::FILLED);
+        cv::rectangle(frames[i].image, cv::Rect(150 + 6 * (i / 3), 120, 70, 70), cv::Scalar(0, 0, 255), cv::FILLED);
+        frames[i].meta.sequence = static_cast<std::uint64_t>(i);
+    }
+    return frames;
+}
+
+// Annotations of each frame processed on a number of lanes, in the order
+// the frames were emitted
+static std::vector<annotation_list> process(
+    const std::shared_ptr<VideoModifier> &modifier,
+    int lanes,
+    const std::vector<Frame> &frames,
+    bool &concurrent
+) {
+    Preprocessor preprocessor;
+    preprocessor.set_queue_policy(Preprocessor::frame_queue::FIFO, static_cast<int>(frames.size()));
+    preprocessor.use_modifier(modifier);
+    preprocessor.set_frames_in_flight(lanes);
+    std::vector<annotation_list> found;
+    std::thread::id caller = std::this_thread::get_id();
+    concurrent = false;
+    // Emitted by one thread at a time
+    QObject::connect(&preprocessor, &Preprocessor::frame_processed, [&](const Frame &frame) {
+        EXPECT_EQ(found.size(), frame.meta.sequence);
+        found.push_back(frame.meta.annotations ? *frame.meta.annotations : annotation_list());
+        if (std::this_thread::get_id() != caller) { concurrent = true; }
+    });
+    for (const Frame &frame : frames) { preprocessor.preprocess_frame(frame); }
+    preprocessor.process_queue();
+    // Wait for the frames in flight
+    preprocessor.set_frames_in_flight(1);
+    return found;
+}
+
+TEST(preprocessor, gated_modifiers_match_across_lanes) {
+    std::vector<Frame> frames = moving_square(24);
+    std::vector<std::function<std::shared_ptr<VideoModifier>()>> modifiers{
+        [] { return std::make_shared<Squares>(); },
+        [] { return std::make_shared<ShapeDetect>(Denoiser::TEMPORAL); },
+        [] { return std::make_shared<ShapeDetect>(Denoiser::GAUSSIAN); }
+    };
+    for (const auto &make : modifiers) {
+        bool concurrent;
+        std::vector<annotation_list> single = process(make(), 1, frames, concurrent);
+        ASSERT_FALSE(concurrent);
+        std::vector<annotation_list> lanes = process(make(), 4, frames, concurrent);
+        ASSERT_TRUE(concurrent);
+        ASSERT_EQ(frames.size(), single.size());
+        ASSERT_EQ(frames.size(), lanes.size());
+        for (std::size_t i = 0; i < frames.size(); ++i) {
+            ASSERT_FALSE(single[i].empty());
+            ASSERT_EQ(single[i].size(), lanes[i].size()) << "frame " << i;
+            for (std::size_t j = 0; j < single[i].size(); ++j) {
+                ASSERT_EQ(single[i][j].outline, lanes[i][j].outline) << "frame " << i;
+            }
+        }
+    }
+}
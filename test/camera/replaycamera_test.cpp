@@ -0,0 +1,70 @@
+#include <gtest/gtest.h>
+
+#include <code/camera/replaycamera.h>
+#include <code/camera/session.h>
+
+#include <QTemporaryDir>
+#include <chrono>
+
+static cv::Mat numbered_frame(int n) {
+    return cv::Mat(24, 32, CV_8UC3, cv::Scalar(n, n + 1, n + 2));
+}
+
+static void write_session(const QString &file, int frames) {
+    SessionWriter writer;
+    ASSERT_TRUE(writer.open(file));
+    for (int i = 0; i < frames; ++i) {
+        FrameMeta meta;
+        meta.sequence = static_cast<std::uint64_t>(i);
+        // 100 frames per second
+        meta.capture_time = 10000000LL * i;
+        ASSERT_TRUE(writer.write(numbered_frame(i), meta));
+    }
+}
+
+TEST(replay_camera, plays_session_in_order) {
+    QTemporaryDir dir;
+    QString file = dir.filePath("replay.session");
+    write_session(file, 4);
+
+    ReplayCamera camera(file.toStdString(), ReplayCamera::AS_FAST_AS_POSSIBLE);
+    ASSERT_TRUE(camera.isOpened());
+    ASSERT_EQ(32, camera.get(cv::CAP_PROP_FRAME_WIDTH));
+    ASSERT_EQ(24, camera.get(cv::CAP_PROP_FRAME_HEIGHT));
+    ASSERT_EQ(4, camera.get(cv::CAP_PROP_FRAME_COUNT));
+    ASSERT_NEAR(100, camera.get(cv::CAP_PROP_FPS), 1e-6);
+
+    cv::Mat image;
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_TRUE(camera.read(image));
+        ASSERT_EQ(0, cv::norm(image, numbered_frame(i), cv::NORM_INF));
+    }
+    ASSERT_FALSE(camera.grab());
+}
+
+TEST(replay_camera, seeks) {
+    QTemporaryDir dir;
+    QString file = dir.filePath("replay.session");
+    write_session(file, 4);
+
+    ReplayCamera camera(file.toStdString(), ReplayCamera::AS_FAST_AS_POSSIBLE);
+    ASSERT_TRUE(camera.set(cv::CAP_PROP_POS_FRAMES, 2));
+    ASSERT_EQ(2, camera.get(cv::CAP_PROP_POS_FRAMES));
+    cv::Mat image;
+    ASSERT_TRUE(camera.read(image));
+    ASSERT_EQ(0, cv::norm(image, numbered_frame(2), cv::NORM_INF));
+    ASSERT_FALSE(camera.set(cv::CAP_PROP_POS_FRAMES, 5));
+}
+
+TEST(replay_camera, paces_in_real_time) {
+    QTemporaryDir dir;
+    QString file = dir.filePath("replay.session");
+    write_session(file, 4);
+
+    ReplayCamera camera(file.toStdString(), ReplayCamera::REAL_TIME);
+    auto start = std::chrono::steady_clock::now();
+    cv::Mat image;
+    while (camera.read(image)) {}
+    // Three intervals of 10 ms separate the four frames
+    ASSERT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(30));
+}
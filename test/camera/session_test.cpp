@@ -0,0 +1,74 @@
+#include <gtest/gtest.h>
+
+#include <code/camera/session.h>
+
+#include <QFile>
+#include <QTemporaryDir>
+
+static cv::Mat numbered_frame(int n) {
+    return cv::Mat(24, 32, CV_8UC3, cv::Scalar(n, n + 1, n + 2));
+}
+
+static void write_session(const QString &file, session::Compression compression, int frames) {
+    SessionWriter writer(compression);
+    ASSERT_TRUE(writer.open(file));
+    for (int i = 0; i < frames; ++i) {
+        FrameMeta meta;
+        meta.sequence = static_cast<std::uint64_t>(i);
+        meta.capture_time = 1000 * i;
+        meta.exit_time[FrameMeta::MODIFY] = 1000 * i + 5;
+        ASSERT_TRUE(writer.write(numbered_frame(i), meta));
+    }
+    ASSERT_EQ(frames, writer.size());
+}
+
+static void check_frame(const SessionReader &reader, int n) {
+    cv::Mat image;
+    FrameMeta meta;
+    ASSERT_TRUE(reader.read(static_cast<std::size_t>(n), image, meta));
+    ASSERT_EQ(0, cv::norm(image, numbered_frame(n), cv::NORM_INF));
+    ASSERT_EQ(static_cast<std::uint64_t>(n), meta.sequence);
+    ASSERT_EQ(1000 * n, meta.capture_time);
+    ASSERT_EQ(1000 * n + 5, meta.exit_time[FrameMeta::MODIFY]);
+}
+
+TEST(session, random_access) {
+    QTemporaryDir dir;
+    QString file = dir.filePath("raw.session");
+    write_session(file, session::RAW, 5);
+
+    SessionReader reader;
+    ASSERT_TRUE(reader.open(file));
+    ASSERT_EQ(5, reader.size());
+    check_frame(reader, 3);
+    check_frame(reader, 0);
+    check_frame(reader, 4);
+    cv::Mat image;
+    FrameMeta meta;
+    ASSERT_FALSE(reader.read(5, image, meta));
+}
+
+TEST(session, compressed) {
+    QTemporaryDir dir;
+    QString file = dir.filePath("png.session");
+    write_session(file, session::PNG, 3);
+
+    SessionReader reader;
+    ASSERT_TRUE(reader.open(file));
+    ASSERT_EQ(3, reader.size());
+    check_frame(reader, 2);
+}
+
+TEST(session, scans_unclosed_session) {
+    QTemporaryDir dir;
+    QString file = dir.filePath("cut.session");
+    write_session(file, session::RAW, 4);
+    // Drop the index and footer, and cut into the last record
+    QFile cut(file);
+    ASSERT_TRUE(cut.resize(cut.size() - 4 * 8 - 24 - 100));
+
+    SessionReader reader;
+    ASSERT_TRUE(reader.open(file));
+    ASSERT_EQ(3, reader.size());
+    check_frame(reader, 2);
+}
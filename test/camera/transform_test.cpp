@@ -0,0 +1,24 @@
+#include <gtest/gtest.h>
+
+#include <code/camera/transform.h>
+
+TEST(transform, unmap_inverts_map) {
+    cv::Size size(80, 60);
+    for (double angle : {0.0, 30.0, -90.0}) {
+        for (double zoom : {1.0, 1.5}) {
+            std::vector<cv::Point> points{{10, 50}};
+            FrameTransform::map(points, size, angle, zoom);
+            cv::Point2d back = FrameTransform::unmap(points[0], size, angle, zoom);
+            // Mapped points are rounded to pixels
+            ASSERT_NEAR(10, back.x, 1);
+            ASSERT_NEAR(50, back.y, 1);
+        }
+    }
+}
+
+TEST(transform, unmap_undoes_zoom) {
+    // Zooming by two about the center doubles distances from it
+    cv::Point2d back = FrameTransform::unmap(cv::Point2d(60, 20), cv::Size(40, 40), 0.0, 2.0);
+    ASSERT_DOUBLE_EQ(40, back.x);
+    ASSERT_DOUBLE_EQ(20, back.y);
+}
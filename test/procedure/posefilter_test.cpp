@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+
+#include <code/compstate/posefilter.h>
+
+#include <algorithm>
+#include <cmath>
+
+static constexpr std::int64_t NS_PER_S = 1000000000;
+
+TEST(pose_filter, follows_constant_velocity) {
+    PoseFilter filter;
+    // Moving at 50 pixels per second along x, measured at 30 Hz
+    for (int i = 0; i < 60; ++i) {
+        double t = i / 30.0;
+        filter.measure(cv::Rect2d(100 + 50 * t, 200, 10, 10), static_cast<std::int64_t>(t * NS_PER_S));
+    }
+    PoseEstimate pose = filter.estimate(3 * NS_PER_S);
+    ASSERT_TRUE(pose.valid);
+    ASSERT_NEAR(50, pose.velocity.x, 0.5);
+    ASSERT_NEAR(0, pose.velocity.y, 0.5);
+    // Predicted a second past the last measurement
+    ASSERT_NEAR(255, pose.position.x, 1);
+    ASSERT_NEAR(205, pose.position.y, 1);
+    ASSERT_EQ(3 * NS_PER_S, pose.time);
+    cv::Rect2d box = pose.box();
+    ASSERT_NEAR(250, box.x, 1);
+    ASSERT_NEAR(200, box.y, 1);
+    ASSERT_EQ(10, box.width);
+}
+
+TEST(pose_filter, predicts_commanded_motion) {
+    PoseFilter filter;
+    filter.measure(cv::Rect2d(0, 0, 10, 10), 0);
+    // Commanded at 100 pixels per second for half a second
+    filter.command(cv::Point2d(100, 0), 0, NS_PER_S / 2);
+    ASSERT_NEAR(30, filter.estimate(NS_PER_S / 4).position.x, 1e-6);
+    ASSERT_NEAR(55, filter.estimate(NS_PER_S).position.x, 1e-6);
+    // The measurement time is kept apart from the prediction time
+    ASSERT_EQ(0, filter.estimate(NS_PER_S).measured_time);
+}
+
+TEST(pose_filter, command_replaces_filtered_velocity) {
+    PoseFilter filter;
+    // Moving at 50 pixels per second along x until two seconds
+    for (int i = 0; i <= 60; ++i) {
+        double t = i / 30.0;
+        filter.measure(cv::Rect2d(100 + 50 * t, 200, 10, 10), static_cast<std::int64_t>(t * NS_PER_S));
+    }
+    // Commanded back at 100 pixels per second for half a second, then
+    // superseded by a stop a quarter second in
+    filter.command(cv::Point2d(-100, 0), 2 * NS_PER_S, 5 * NS_PER_S / 2);
+    ASSERT_NEAR(155, filter.estimate(5 * NS_PER_S / 2).position.x, 1);
+    filter.command(cv::Point2d(0, 0), 9 * NS_PER_S / 4, 5 * NS_PER_S / 2);
+    ASSERT_NEAR(180, filter.estimate(5 * NS_PER_S / 2).position.x, 1);
+    // The filtered velocity carries on once the commands end
+    ASSERT_NEAR(205, filter.estimate(3 * NS_PER_S).position.x, 1);
+}
+
+TEST(pose_filter, smooths_measurement_noise) {
+    PoseFilter filter;
+    filter.set_noise(1, 16);
+    double worst = 0;
+    for (int i = 0; i < 100; ++i) {
+        // Alternate four pixels either side of a still target
+        double noise = i % 2 ? 4 : -4;
+        std::int64_t time = i * NS_PER_S / 30;
+        filter.measure(cv::Rect2d(100 + noise, 100, 10, 10), time);
+        if (i > 30) { worst = std::max(worst, std::abs(filter.estimate(time).position.x - 105)); }
+    }
+    ASSERT_LT(worst, 2);
+}
+
+TEST(pose_filter, resets) {
+    PoseFilter filter;
+    ASSERT_FALSE(filter.estimate(0).valid);
+    filter.measure(cv::Rect2d(0, 0, 10, 10), 0);
+    ASSERT_TRUE(filter.valid());
+    filter.reset();
+    ASSERT_FALSE(filter.valid());
+    // The next measurement starts afresh
+    filter.measure(cv::Rect2d(100, 100, 10, 10), NS_PER_S);
+    ASSERT_EQ(cv::Point2d(105, 105), filter.estimate(NS_PER_S).position);
+}
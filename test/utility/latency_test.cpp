@@ -0,0 +1,25 @@
+#include <gtest/gtest.h>
+
+#include <code/utility/latency.h>
+
+TEST(latency_window, empty_is_zero) {
+    latency_window window;
+    ASSERT_EQ(0, window.percentile(50));
+}
+
+TEST(latency_window, percentiles) {
+    latency_window window(100);
+    for (int i = 100; i >= 1; --i) { window.add(i); }
+    ASSERT_EQ(51, window.percentile(50));
+    ASSERT_EQ(95, window.percentile(95));
+    ASSERT_EQ(99, window.percentile(99));
+    ASSERT_EQ(100, window.percentile(100));
+}
+
+TEST(latency_window, keeps_most_recent) {
+    latency_window window(4);
+    for (int i = 0; i < 4; ++i) { window.add(1000); }
+    for (int i = 0; i < 4; ++i) { window.add(1); }
+    ASSERT_EQ(4, window.count());
+    ASSERT_EQ(1, window.percentile(99));
+}
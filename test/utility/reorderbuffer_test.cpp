@@ -0,0 +1,46 @@
+#include <gtest/gtest.h>
+
+#include <code/utility/reorderbuffer.h>
+
+TEST(reorder_buffer, pops_in_ticket_order) {
+    reorder_buffer<int> rb(4);
+    int value = 0;
+    ASSERT_TRUE(rb.put(2, 20));
+    ASSERT_TRUE(rb.put(1, 10));
+    ASSERT_FALSE(rb.pop(value));
+    ASSERT_TRUE(rb.put(0, 0));
+    ASSERT_EQ(3, rb.size());
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_TRUE(rb.pop(value));
+        ASSERT_EQ(10 * i, value);
+    }
+    ASSERT_FALSE(rb.pop(value));
+    ASSERT_EQ(3, rb.next());
+    ASSERT_EQ(0, rb.size());
+}
+
+TEST(reorder_buffer, rejects_outside_window) {
+    reorder_buffer<int> rb(2, 5);
+    ASSERT_FALSE(rb.put(4, 0));
+    ASSERT_FALSE(rb.put(7, 0));
+    ASSERT_TRUE(rb.put(6, 6));
+    ASSERT_FALSE(rb.put(6, 6));
+    ASSERT_TRUE(rb.put(5, 5));
+    int value = 0;
+    ASSERT_TRUE(rb.pop(value));
+    ASSERT_EQ(5, value);
+    // The window has moved past the popped ticket
+    ASSERT_TRUE(rb.accepts(7));
+    ASSERT_FALSE(rb.accepts(5));
+}
+
+TEST(reorder_buffer, reset) {
+    reorder_buffer<int> rb(2);
+    ASSERT_TRUE(rb.put(0, 1));
+    rb.reset(3, 10);
+    int value = 0;
+    ASSERT_FALSE(rb.pop(value));
+    ASSERT_EQ(3, rb.window());
+    ASSERT_EQ(10, rb.next());
+    ASSERT_TRUE(rb.put(12, 12));
+}
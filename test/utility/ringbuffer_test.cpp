@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+
+#include <code/utility/ringbuffer.h>
+
+TEST(ring_buffer, latest_keeps_newest) {
+    ring_buffer<int> rb(4, ring_buffer<int>::LATEST);
+    ASSERT_EQ(1, rb.capacity());
+    ASSERT_TRUE(rb.push(1));
+    ASSERT_TRUE(rb.push(2));
+    ASSERT_TRUE(rb.push(3));
+    int value = 0;
+    ASSERT_TRUE(rb.pop(value));
+    ASSERT_EQ(3, value);
+    ASSERT_FALSE(rb.pop(value));
+    ring_buffer_stats stats = rb.stats();
+    ASSERT_EQ(3, stats.enqueued);
+    ASSERT_EQ(2, stats.dropped);
+    ASSERT_EQ(1, stats.processed);
+}
+
+TEST(ring_buffer, fifo_rejects_when_full) {
+    ring_buffer<int> rb(3, ring_buffer<int>::FIFO);
+    for (int i = 0; i < 5; ++i) { rb.push(i); }
+    int value = 0;
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_TRUE(rb.pop(value));
+        ASSERT_EQ(i, value);
+    }
+    ASSERT_TRUE(rb.empty());
+    ring_buffer_stats stats = rb.stats();
+    ASSERT_EQ(3, stats.enqueued);
+    ASSERT_EQ(2, stats.dropped);
+    ASSERT_EQ(3, stats.processed);
+}
+
+TEST(ring_buffer, drop_oldest_evicts) {
+    ring_buffer<int> rb(3, ring_buffer<int>::DROP_OLDEST);
+    for (int i = 0; i < 5; ++i) { ASSERT_TRUE(rb.push(i)); }
+    int value = 0;
+    for (int i = 2; i < 5; ++i) {
+        ASSERT_TRUE(rb.pop(value));
+        ASSERT_EQ(i, value);
+    }
+    ASSERT_FALSE(rb.pop(value));
+    ASSERT_EQ(2, rb.stats().dropped);
+}
+
+TEST(ring_buffer, fifo_threaded_order) {
+    constexpr int count = 100000;
+    ring_buffer<int> rb(16, ring_buffer<int>::FIFO);
+    std::thread producer([&rb]() {
+        for (int i = 0; i < count; ++i) {
+            while (!rb.push(i)) { std::this_thread::yield(); }
+        }
+    });
+    int expected = 0;
+    int value;
+    while (expected < count) {
+        if (rb.pop(value)) {
+            ASSERT_EQ(expected, value);
+            ++expected;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+    ASSERT_EQ(count, rb.stats().processed);
+}
+
+TEST(ring_buffer, eviction_races_consumer) {
+    constexpr int count = 100000;
+    for (auto policy : {ring_buffer<int>::DROP_OLDEST, ring_buffer<int>::LATEST}) {
+        ring_buffer<int> rb(4, policy);
+        std::atomic<bool> done(false);
+        // The producer evicts with the same compare-and-swap the consumer
+        // pops with, so each element is either popped or dropped, once
+        std::thread producer([&rb, &done]() {
+            for (int i = 0; i < count; ++i) {
+                rb.push(i);
+                if (i % 64 == 0) { std::this_thread::yield(); }
+            }
+            done = true;
+        });
+        int last = -1;
+        bool ordered = true;
+        std::size_t popped = 0;
+        int value;
+        for (;;) {
+            bool finished = done;
+            if (rb.pop(value)) {
+                ordered = ordered && value > last;
+                last = value;
+                ++popped;
+            } else if (finished) {
+                break;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        producer.join();
+        ASSERT_TRUE(ordered);
+        ring_buffer_stats stats = rb.stats();
+        ASSERT_EQ(popped, stats.processed);
+        ASSERT_EQ(count, stats.processed + stats.dropped);
+    }
+}
+
+TEST(ring_buffer, try_push_does_not_drop) {
+    ring_buffer<int> rb(2, ring_buffer<int>::DROP_OLDEST);
+    ASSERT_TRUE(rb.try_push(1));
+    ASSERT_TRUE(rb.try_push(2));
+    // A full buffer rejects the element without evicting or counting it
+    ASSERT_FALSE(rb.try_push(3));
+    ASSERT_EQ(0, rb.stats().dropped);
+    int value = 0;
+    ASSERT_TRUE(rb.pop(value));
+    ASSERT_EQ(1, value);
+    ASSERT_TRUE(rb.try_push(3));
+}
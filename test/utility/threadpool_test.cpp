@@ -0,0 +1,18 @@
+#include <gtest/gtest.h>
+
+#include <code/utility/threadpool.h>
+
+#include <atomic>
+
+TEST(thread_pool, runs_every_task) {
+    std::atomic<int> count(0);
+    {
+        thread_pool pool(3);
+        ASSERT_EQ(3, pool.size());
+        for (int i = 0; i < 100; ++i) {
+            pool.post([&count] { ++count; });
+        }
+    }
+    // Pending tasks finish before the pool is destroyed
+    ASSERT_EQ(100, count.load());
+}
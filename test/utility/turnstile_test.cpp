@@ -0,0 +1,35 @@
+#include <gtest/gtest.h>
+
+#include <code/utility/turnstile.h>
+
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+TEST(turnstile, passes_tickets_in_order) {
+    turnstile gate;
+    std::vector<int> order;
+    std::vector<std::thread> threads;
+    // Started in reverse, so most threads wait for those after them
+    for (int ticket = 7; ticket >= 0; --ticket) {
+        threads.emplace_back([&gate, &order, ticket] {
+            turnstile::guard turn(gate, ticket);
+            order.push_back(ticket);
+        });
+    }
+    for (std::thread &thread : threads) { thread.join(); }
+    ASSERT_EQ(8, order.size());
+    for (int i = 0; i < 8; ++i) { ASSERT_EQ(i, order[i]); }
+    ASSERT_EQ(8, gate.next());
+}
+
+TEST(turnstile, passes_on_exception) {
+    turnstile gate(3);
+    try {
+        turnstile::guard turn(gate, 3);
+        throw std::runtime_error("failed");
+    } catch (const std::runtime_error &) {}
+    ASSERT_EQ(4, gate.next());
+    gate.reset();
+    ASSERT_EQ(0, gate.next());
+}
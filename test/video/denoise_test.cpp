@@ -0,0 +1,54 @@
+#include <gtest/gtest.h>
+
+#include <code/video/denoise.h>
+
+TEST(denoise, keeps_size_and_type) {
+    cv::UMat gray(cv::Size(64, 48), CV_8U, cv::Scalar(100));
+    for (int method = 0; method < Denoiser::NUM_METHODS; ++method) {
+        Denoiser denoiser(method);
+        cv::UMat denoised;
+        denoiser.apply(gray, denoised);
+        ASSERT_EQ(gray.size(), denoised.size()) << Denoiser::name(method);
+        ASSERT_EQ(CV_8U, denoised.type()) << Denoiser::name(method);
+    }
+}
+
+TEST(denoise, temporal_average_converges) {
+    Denoiser denoiser(Denoiser::TEMPORAL);
+    cv::UMat denoised;
+    denoiser.apply(cv::UMat(cv::Size(32, 32), CV_8U, cv::Scalar(0)), denoised);
+    ASSERT_EQ(0, cv::mean(denoised)[0]);
+    cv::UMat bright(cv::Size(32, 32), CV_8U, cv::Scalar(200));
+    denoiser.apply(bright, denoised);
+    // The newest frame is weighted in, not taken as is
+    ASSERT_GT(cv::mean(denoised)[0], 0);
+    ASSERT_LT(cv::mean(denoised)[0], 200);
+    for (int i = 0; i < 30; ++i) { denoiser.apply(bright, denoised); }
+    ASSERT_NEAR(200, cv::mean(denoised)[0], 1);
+}
+
+TEST(denoise, temporal_average_restarts) {
+    Denoiser denoiser(Denoiser::TEMPORAL);
+    cv::UMat denoised;
+    denoiser.apply(cv::UMat(cv::Size(32, 32), CV_8U, cv::Scalar(0)), denoised);
+    // A new frame size, or a reset, starts from the next frame
+    denoiser.apply(cv::UMat(cv::Size(16, 16), CV_8U, cv::Scalar(200)), denoised);
+    ASSERT_EQ(200, cv::mean(denoised)[0]);
+    denoiser.reset();
+    denoiser.apply(cv::UMat(cv::Size(16, 16), CV_8U, cv::Scalar(50)), denoised);
+    ASSERT_EQ(50, cv::mean(denoised)[0]);
+}
+
+TEST(denoise, median_removes_impulse) {
+    cv::UMat gray(cv::Size(32, 32), CV_8U, cv::Scalar(100));
+    gray.getMat(cv::ACCESS_WRITE).at<uchar>(16, 16) = 255;
+    Denoiser denoiser(Denoiser::MEDIAN);
+    cv::UMat denoised;
+    denoiser.apply(gray, denoised);
+    ASSERT_EQ(100, denoised.getMat(cv::ACCESS_READ).at<uchar>(16, 16));
+}
+
+TEST(denoise, unknown_method_is_non_local_means) {
+    ASSERT_EQ(Denoiser::NON_LOCAL_MEANS, Denoiser(Denoiser::NUM_METHODS).method());
+    ASSERT_EQ(Denoiser::NON_LOCAL_MEANS, Denoiser(-1).method());
+}
@@ -0,0 +1,55 @@
+#include <gtest/gtest.h>
+
+#include <code/camera/framegraph.h>
+#include <code/utility/threadpool.h>
+#include <code/video/modifiergroup.h>
+#include <code/video/pyramid.h>
+
+#include <atomic>
+
+// Detects in two independent parts, each on its own branch
+class split_modifier : public VideoModifier {
+public:
+    split_modifier() : parts(0), drawn(-1) {}
+
+    void detect(const cv::UMat &, ImagePyramid &) override {
+        parts += 2;
+    }
+
+    void draw(cv::UMat &, annotation_list &) override {
+        drawn = parts.load();
+    }
+
+    std::vector<std::size_t> add_detect_nodes(FrameGraph &graph, const std::vector<std::size_t> &inputs) override {
+        return {
+            graph.add_node("first", [this](FrameContext &) { ++parts; }, inputs),
+            graph.add_node("second", [this](FrameContext &) { ++parts; }, inputs)
+        };
+    }
+
+    std::atomic<int> parts;
+    int drawn;
+};
+
+TEST(modifier_group, joins_every_detection_branch) {
+    thread_pool pool(2);
+    FrameGraph graph(pool);
+    auto first = std::make_shared<split_modifier>();
+    auto second = std::make_shared<split_modifier>();
+    ModifierGroup group({first, second});
+    FrameGraph::node_id root = graph.add_node("root", [](FrameContext &) {});
+    group.add_nodes(graph, {root});
+    // Two branches for each modifier and the join
+    ASSERT_EQ(6, graph.size());
+
+    Frame frame;
+    ImagePyramid pyramid;
+    FrameContext context{frame, pyramid};
+    for (int i = 0; i < 20; ++i) {
+        first->parts = 0;
+        second->parts = 0;
+        graph.run(context);
+        ASSERT_EQ(2, first->drawn);
+        ASSERT_EQ(2, second->drawn);
+    }
+}
@@ -0,0 +1,48 @@
+#include <gtest/gtest.h>
+
+#include <code/video/motiongate.h>
+#include <code/video/pyramid.h>
+
+static MotionGate::Action update(MotionGate &gate, const cv::UMat &frame) {
+    ImagePyramid pyramid(frame);
+    return gate.update(pyramid);
+}
+
+TEST(motion_gate, reuses_unchanged_frame) {
+    cv::UMat frame(cv::Size(256, 256), CV_8UC3, cv::Scalar(40, 40, 40));
+    MotionGate gate;
+    ASSERT_EQ(MotionGate::DETECT, update(gate, frame));
+    ASSERT_EQ(MotionGate::REUSE, update(gate, frame));
+    ASSERT_TRUE(gate.regions().empty());
+}
+
+TEST(motion_gate, detects_changed_region) {
+    cv::UMat frame(cv::Size(256, 256), CV_8UC3, cv::Scalar(40, 40, 40));
+    MotionGate gate;
+    update(gate, frame);
+    cv::Rect block(40, 40, 16, 16);
+    frame(block).setTo(cv::Scalar(255, 255, 255));
+    ASSERT_EQ(MotionGate::DETECT_REGIONS, update(gate, frame));
+    ASSERT_EQ(1, gate.regions().size());
+    const cv::Rect &region = gate.regions().front();
+    ASSERT_EQ(block, region & block);
+    ASSERT_LT(region.area(), 256 * 256 / 4);
+    // The reference has moved on where detection ran again
+    ASSERT_EQ(MotionGate::REUSE, update(gate, frame));
+}
+
+TEST(motion_gate, detects_whole_frame_change) {
+    MotionGate gate;
+    update(gate, cv::UMat(cv::Size(256, 256), CV_8UC3, cv::Scalar(40, 40, 40)));
+    ASSERT_EQ(MotionGate::DETECT, update(gate, cv::UMat(cv::Size(256, 256), CV_8UC3, cv::Scalar(200, 200, 200))));
+    // A new frame size has no reference
+    ASSERT_EQ(MotionGate::DETECT, update(gate, cv::UMat(cv::Size(128, 128), CV_8UC3, cv::Scalar(200, 200, 200))));
+}
+
+TEST(motion_gate, cover_grows_to_whole_boxes) {
+    std::vector<cv::Rect> boxes{{30, 0, 20, 10}, {45, 5, 20, 10}, {200, 200, 10, 10}};
+    std::vector<bool> covered;
+    cv::Rect region = MotionGate::cover(cv::Rect(0, 0, 32, 32), boxes, covered);
+    ASSERT_EQ(cv::Rect(0, 0, 65, 32), region);
+    ASSERT_EQ((std::vector<bool>{true, true, false}), covered);
+}
@@ -0,0 +1,28 @@
+#include <gtest/gtest.h>
+
+#include <code/video/pyramid.h>
+
+TEST(image_pyramid, level_sizes) {
+    cv::UMat frame(cv::Size(64, 48), CV_8UC3, cv::Scalar(10, 20, 30));
+    ImagePyramid pyramid(frame);
+    ASSERT_EQ(cv::Size(64, 48), pyramid.color(ImagePyramid::FULL).size());
+    ASSERT_EQ(cv::Size(32, 24), pyramid.color(ImagePyramid::HALF).size());
+    ASSERT_EQ(cv::Size(16, 12), pyramid.color(ImagePyramid::QUARTER).size());
+    ASSERT_EQ(cv::Size(16, 12), pyramid.gray(ImagePyramid::QUARTER).size());
+    ASSERT_EQ(1, pyramid.gray(ImagePyramid::HALF).channels());
+}
+
+TEST(image_pyramid, reset_rebuilds_levels) {
+    cv::UMat black(cv::Size(32, 32), CV_8UC3, cv::Scalar(0, 0, 0));
+    cv::UMat white(cv::Size(32, 32), CV_8UC3, cv::Scalar(255, 255, 255));
+    ImagePyramid pyramid(black);
+    ASSERT_EQ(0, cv::countNonZero(pyramid.gray(ImagePyramid::HALF)));
+    pyramid.reset(white);
+    ASSERT_EQ(16 * 16, cv::countNonZero(pyramid.gray(ImagePyramid::HALF)));
+}
+
+TEST(image_pyramid, released_is_empty) {
+    ImagePyramid pyramid;
+    ASSERT_TRUE(pyramid.color(ImagePyramid::HALF).empty());
+    ASSERT_TRUE(pyramid.gray(ImagePyramid::FULL).empty());
+}
@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+
+#include <code/video/searchwindow.h>
+
+TEST(search_window, clamps_to_frame_edges) {
+    cv::Size frame(640, 480);
+    SearchWindow top_left;
+    ASSERT_TRUE(top_left.follow(cv::Rect2d(0, 0, 20, 20), frame));
+    ASSERT_EQ(cv::Rect(0, 0, 96, 96), top_left.rect());
+    // Shifted back inside the frame rather than shrunk
+    SearchWindow bottom_right;
+    ASSERT_TRUE(bottom_right.follow(cv::Rect2d(620, 460, 20, 20), frame));
+    ASSERT_EQ(cv::Rect(544, 384, 96, 96), bottom_right.rect());
+    // No larger than the frame
+    SearchWindow small_frame;
+    small_frame.follow(cv::Rect2d(10, 10, 10, 10), cv::Size(64, 48));
+    ASSERT_EQ(cv::Rect(0, 0, 64, 48), small_frame.rect());
+}
+
+TEST(search_window, moves_ahead_of_predicted_motion) {
+    cv::Size frame(640, 480);
+    SearchWindow window;
+    ASSERT_TRUE(window.follow(cv::Rect2d(100, 100, 20, 20), frame));
+    ASSERT_EQ(cv::Rect(62, 62, 96, 96), window.rect());
+    // Moving right by 10 pixels a frame, well inside the window
+    ASSERT_FALSE(window.follow(cv::Rect2d(110, 100, 20, 20), frame));
+    ASSERT_FALSE(window.follow(cv::Rect2d(120, 100, 20, 20), frame));
+    ASSERT_DOUBLE_EQ(127.5, window.predict(cv::Rect2d(120, 100, 20, 20)).x);
+    // The predicted box nears the edge, and the window is centered on it
+    ASSERT_TRUE(window.follow(cv::Rect2d(130, 100, 20, 20), frame));
+    ASSERT_EQ(cv::Rect(100, 62, 96, 96), window.rect());
+    // Coordinates map between the frame and the window
+    cv::Rect2d local = window.to_local(cv::Rect2d(130, 100, 20, 20));
+    ASSERT_EQ(cv::Rect2d(30, 38, 20, 20), local);
+    ASSERT_EQ(cv::Rect2d(130, 100, 20, 20), window.to_frame(local));
+}
+
+TEST(search_window, widens_after_miss_to_full_frame) {
+    cv::Size frame(640, 480);
+    cv::Rect2d box(300, 220, 20, 20);
+    SearchWindow window;
+    window.follow(box, frame);
+    ASSERT_EQ(cv::Size(96, 96), window.rect().size());
+    // Each consecutive failure doubles the window about the target
+    window.widen(box, frame);
+    ASSERT_EQ(cv::Rect(230, 150, 160, 160), window.rect());
+    window.widen(box, frame);
+    ASSERT_EQ(cv::Rect(150, 70, 320, 320), window.rect());
+    window.widen(box, frame);
+    ASSERT_EQ(cv::Rect(0, 0, 640, 480), window.rect());
+    // Tracking again returns to the normal size
+    ASSERT_TRUE(window.follow(box, frame));
+    ASSERT_EQ(cv::Rect(262, 182, 96, 96), window.rect());
+}
+
+TEST(search_window, widens_about_predicted_position) {
+    cv::Size frame(640, 480);
+    cv::Rect2d box(300, 220, 20, 20);
+    SearchWindow window;
+    window.follow(box, frame);
+    // A filtered velocity from elsewhere moves the search ahead
+    window.set_velocity(cv::Point2d(40, 0));
+    window.widen(box, frame);
+    ASSERT_EQ(cv::Rect(270, 150, 160, 160), window.rect());
+    window.reset();
+    ASSERT_EQ(0, window.rect().area());
+    ASSERT_EQ(box, window.predict(box));
+}
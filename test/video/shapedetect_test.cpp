@@ -0,0 +1,51 @@
+#include <gtest/gtest.h>
+
+#include <code/camera/frame.h>
+#include <code/compstate/compstate.h>
+#include <code/video/pyramid.h>
+#include <code/video/shapedetect.h>
+
+static detection_list detect_shapes(ShapeDetect &detect, const cv::UMat &frame) {
+    ImagePyramid pyramid(frame);
+    detect.detect(frame, pyramid);
+    FrameMeta meta;
+    detect.report(meta);
+    return meta.detections ? *meta.detections : detection_list();
+}
+
+TEST(shape_detect, reports_detections) {
+    cv::UMat frame(cv::Size(200, 200), CV_8UC3, cv::Scalar(0, 0, 0));
+    cv::rectangle(frame, cv::Rect(40, 60, 80, 80), cv::Scalar(255, 255, 255), cv::FILLED);
+    ShapeDetect detect(Denoiser::GAUSSIAN);
+    detection_list found = detect_shapes(detect, frame);
+    ASSERT_EQ(1, found.size());
+    const Detection &square = found.front();
+    ASSERT_EQ(CompetitionState::SQUARE, square.type);
+    ASSERT_NEAR(40, square.box.x, 3);
+    ASSERT_NEAR(60, square.box.y, 3);
+    ASSERT_NEAR(80, square.centroid.x, 3);
+    ASSERT_NEAR(100, square.centroid.y, 3);
+    ASSERT_GT(square.confidence, 0.9);
+    ASSERT_LE(square.confidence, 1.0);
+}
+
+TEST(shape_detect, scores_against_regular_shape) {
+    // An elongated rectangle is a poor match for a square
+    cv::UMat frame(cv::Size(200, 200), CV_8UC3, cv::Scalar(0, 0, 0));
+    cv::rectangle(frame, cv::Rect(20, 80, 150, 40), cv::Scalar(255, 255, 255), cv::FILLED);
+    ShapeDetect detect(Denoiser::GAUSSIAN);
+    detection_list found = detect_shapes(detect, frame);
+    ASSERT_EQ(1, found.size());
+    ASSERT_EQ(CompetitionState::SQUARE, found.front().type);
+    ASSERT_LT(found.front().confidence, 0.5);
+}
+
+TEST(shape_detect, skips_detection_while_locked) {
+    cv::UMat frame(cv::Size(200, 200), CV_8UC3, cv::Scalar(0, 0, 0));
+    cv::rectangle(frame, cv::Rect(40, 60, 80, 80), cv::Scalar(255, 255, 255), cv::FILLED);
+    ShapeDetect detect(Denoiser::GAUSSIAN);
+    detect.set_object_locked(true);
+    ASSERT_TRUE(detect_shapes(detect, frame).empty());
+    detect.set_object_locked(false);
+    ASSERT_EQ(1, detect_shapes(detect, frame).size());
+}
@@ -0,0 +1,50 @@
+#include <gtest/gtest.h>
+
+#include <code/video/pyramid.h>
+#include <code/video/squares.h>
+
+static annotation_list find_squares(Squares &squares, const cv::UMat &frame) {
+    ImagePyramid pyramid(frame);
+    squares.detect(frame, pyramid);
+    cv::UMat img = frame.clone();
+    annotation_list annotations;
+    squares.draw(img, annotations);
+    return annotations;
+}
+
+TEST(squares, reports_each_square_once) {
+    cv::UMat frame(cv::Size(200, 200), CV_8UC3, cv::Scalar(0, 0, 0));
+    cv::rectangle(frame, cv::Rect(40, 60, 80, 80), cv::Scalar(255, 255, 255), cv::FILLED);
+    for (int method : {Squares::COMPONENT_TREE, Squares::THRESHOLD_SWEEP}) {
+        Squares squares(method);
+        annotation_list found = find_squares(squares, frame);
+        ASSERT_EQ(1, found.size());
+        cv::Rect box = cv::boundingRect(found.front().outline);
+        ASSERT_NEAR(40, box.x, 3);
+        ASSERT_NEAR(60, box.y, 3);
+        ASSERT_NEAR(80, box.width, 6);
+    }
+}
+
+TEST(squares, component_tree_skips_non_squares) {
+    cv::UMat frame(cv::Size(200, 200), CV_8UC3, cv::Scalar(0, 0, 0));
+    cv::circle(frame, cv::Point(60, 60), 30, cv::Scalar(255, 255, 255), cv::FILLED);
+    // Too small to pass the area filter
+    cv::rectangle(frame, cv::Rect(140, 140, 20, 20), cv::Scalar(255, 255, 255), cv::FILLED);
+    Squares squares(Squares::COMPONENT_TREE);
+    ASSERT_TRUE(find_squares(squares, frame).empty());
+}
+
+TEST(squares, sweep_is_deterministic) {
+    cv::UMat frame(cv::Size(240, 240), CV_8UC3, cv::Scalar(0, 0, 0));
+    cv::rectangle(frame, cv::Rect(20, 20, 60, 60), cv::Scalar(0, 0, 255), cv::FILLED);
+    cv::rectangle(frame, cv::Rect(120, 120, 90, 90), cv::Scalar(0, 200, 0), cv::FILLED);
+    Squares squares(Squares::THRESHOLD_SWEEP, 10);
+    annotation_list first = find_squares(squares, frame);
+    ASSERT_EQ(2, first.size());
+    for (int i = 0; i < 5; ++i) {
+        annotation_list again = find_squares(squares, frame);
+        ASSERT_EQ(first.size(), again.size());
+        for (std::size_t j = 0; j < first.size(); ++j) { ASSERT_EQ(first[j].outline, again[j].outline); }
+    }
+}